@@ -0,0 +1,28 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// Simulator side of the HAL shims in hal/: the virtual clock, the heater
+// outputs and the sensors behind the I2C mux, as driven by sim_main.cpp.
+namespace sim {
+
+// Reading of the Si7021 on one mux channel; returns false if none is fitted
+typedef bool (*SensorFn)(uint8_t channel, float &tempC, float &humidity);
+
+void setSensors(SensorFn fn);
+
+// Move the virtual clock forward, firing esp_timers that come due
+void advance(uint32_t ms);
+uint64_t micros64();
+
+// Duty last written to an LEDC channel, 0-255 at PWM_RES 8
+uint32_t heaterDuty(uint8_t channel);
+
+// Console: queue text for Serial.read(), and copy Serial output to stdout
+void serialInput(const char *text);
+void echoSerial(bool on);
+
+} // namespace sim
+
+#endif // SIM_H
@@ -0,0 +1,343 @@
+// Backing state for the HAL shims in hal/: virtual time, GPIO and LEDC
+// levels, FreeRTOS queues, esp_timers, the console, and the I2C devices
+// the firmware expects on its bus.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <EEPROM.h>
+#include <U8g2lib.h>
+#include "driver/ledc.h"
+#include "Sim.h"
+
+#include <stdarg.h>
+#include <chrono>
+#include <string>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+TwoWire Wire;
+EEPROMClass EEPROM;
+
+const uint8_t u8g2_font_ncenB08_tr[1] = {0};
+const uint8_t u8g2_font_5x7_tr[1] = {0};
+
+namespace {
+
+const uint8_t PIN_COUNT = 40;
+const uint8_t LEDC_CHANNELS = 16;
+
+uint64_t nowUs = 0;
+uint8_t pinLevel[PIN_COUNT];
+bool pinsReady = false;
+uint32_t ledcDuty[LEDC_CHANNELS];
+
+std::string serialIn;
+size_t serialPos = 0;
+bool serialEcho = false;
+
+sim::SensorFn sensorFn = nullptr;
+
+uint8_t &pin(uint8_t p) {
+    if (!pinsReady) {
+        memset(pinLevel, HIGH, sizeof(pinLevel)); // everything pulled up
+        pinsReady = true;
+    }
+    return pinLevel[p < PIN_COUNT ? p : 0];
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// FreeRTOS and esp_timer
+
+struct SimQueue {
+    std::vector<uint8_t> data;
+    UBaseType_t itemSize;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+};
+
+struct SimTimer {
+    esp_timer_cb_t callback;
+    void *arg;
+    uint64_t due;
+    bool armed;
+};
+
+namespace {
+std::vector<SimTimer *> timers;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    SimQueue *q = new SimQueue;
+    q->data.resize(length * itemSize);
+    q->itemSize = itemSize;
+    q->length = length;
+    q->head = 0;
+    q->count = 0;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t) {
+    if (!q || q->count >= q->length) return pdFALSE;
+    UBaseType_t tail = (q->head + q->count) % q->length;
+    memcpy(&q->data[tail * q->itemSize], item, q->itemSize);
+    q->count++;
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken) {
+    if (woken) *woken = pdFALSE;
+    return xQueueSend(q, item, 0);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t) {
+    if (!q || q->count == 0) return pdFALSE;
+    memcpy(item, &q->data[q->head * q->itemSize], q->itemSize);
+    q->head = (q->head + 1) % q->length;
+    q->count--;
+    return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    return q ? q->count : 0;
+}
+
+BaseType_t xTaskCreatePinnedToCore(void (*)(void *), const char *, uint32_t, void *,
+                                   UBaseType_t, TaskHandle_t *handle, BaseType_t) {
+    if (handle) *handle = nullptr;
+    return pdPASS;
+}
+
+void vTaskDelay(TickType_t ticks) { sim::advance(ticks); }
+
+void vTaskDelayUntil(TickType_t *previousWake, TickType_t period) {
+    *previousWake += period;
+    if ((int32_t)(*previousWake - xTaskGetTickCount()) > 0) sim::advance(*previousWake - xTaskGetTickCount());
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+TickType_t xTaskGetTickCount() { return (TickType_t)(nowUs / 1000); }
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out) {
+    SimTimer *t = new SimTimer;
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->due = 0;
+    t->armed = false;
+    timers.push_back(t);
+    *out = t;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t t, uint64_t timeoutUs) {
+    if (t->armed) return ESP_FAIL; // as on the IDF: stop it first
+    t->due = nowUs + timeoutUs;
+    t->armed = true;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t t) {
+    if (!t->armed) return ESP_FAIL;
+    t->armed = false;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time() { return (int64_t)nowUs; }
+
+// ---------------------------------------------------------------------------
+// Arduino core
+
+unsigned long millis() { return (unsigned long)(nowUs / 1000); }
+unsigned long micros() { return (unsigned long)nowUs; }
+void delay(unsigned long ms) { sim::advance(ms); }
+void delayMicroseconds(uint32_t us) { nowUs += us; }
+
+void pinMode(uint8_t p, uint8_t mode) {
+    if (mode == INPUT_PULLUP) pin(p) = HIGH;
+}
+
+void digitalWrite(uint8_t p, uint8_t value) { pin(p) = value ? HIGH : LOW; }
+int digitalRead(uint8_t p) { return pin(p); }
+void attachInterrupt(uint8_t, void (*)(), int) {}
+void attachInterruptArg(uint8_t, void (*)(void *), void *, int) {}
+void detachInterrupt(uint8_t) {}
+
+uint32_t ledcSetup(uint8_t, uint32_t freq, uint8_t) { return freq; }
+void ledcAttachPin(uint8_t, uint8_t) {}
+
+void ledcWrite(uint8_t channel, uint32_t duty) {
+    if (channel < LEDC_CHANNELS) ledcDuty[channel] = duty;
+}
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t, ledc_channel_t channel, uint32_t duty, uint32_t) {
+    ledcWrite(channel, duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t channel, uint32_t duty) {
+    ledcWrite(channel, duty);
+    return ESP_OK;
+}
+
+esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t) { return ESP_OK; }
+
+size_t Print::printf(const char *format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (n < 0) return 0;
+    return write((const uint8_t *)buffer, (size_t)n < sizeof(buffer) ? n : sizeof(buffer) - 1);
+}
+
+int HardwareSerial::available() { return (int)(serialIn.size() - serialPos); }
+
+int HardwareSerial::read() {
+    return (serialPos < serialIn.size()) ? (uint8_t)serialIn[serialPos++] : -1;
+}
+
+size_t HardwareSerial::write(uint8_t c) { return write(&c, 1); }
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+    if (serialEcho) fwrite(buffer, 1, size, stdout);
+    return size;
+}
+
+uint32_t EspClass::getCycleCount() {
+    // Host time scaled to the ESP32's 240 MHz, so cycle budgets read the
+    // same way; it measures this machine, not the target
+    using namespace std::chrono;
+    return (uint32_t)(duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count() * 24 / 100);
+}
+
+// ---------------------------------------------------------------------------
+// I2C: the TCA9548A at 0x70 and an Si7021 at 0x40 on each channel the
+// simulator reports a sensor for. RH conversions take CONVERSION_US;
+// reading early is NACKed, as on the real part in no-hold mode.
+
+namespace {
+
+const uint8_t MUX_ADDR = 0x70;
+const uint8_t SI7021_ADDR = 0x40;
+const uint64_t CONVERSION_US = 12000;
+
+struct Si7021 {
+    uint8_t command;
+    uint64_t readyUs;
+    uint16_t rhCode;
+    uint16_t tempCode;
+};
+
+uint8_t muxMask = 0;
+Si7021 si7021[8];
+
+// The one open mux channel, or -1 if none or several are open
+int openChannel() {
+    for (uint8_t ch = 0; ch < 8; ch++)
+        if (muxMask == (1 << ch)) return ch;
+    return -1;
+}
+
+bool sensorAt(int ch, float &tempC, float &humidity) {
+    return ch >= 0 && sensorFn && sensorFn((uint8_t)ch, tempC, humidity);
+}
+
+uint8_t crc8(const uint8_t *data, uint8_t len) {
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++) crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+    }
+    return crc;
+}
+
+uint16_t toCode(float value, float offset, float span) {
+    float code = (value + offset) * 65536.0f / span;
+    return (uint16_t)constrain(code, 0.0f, 65532.0f) & 0xFFFC; // low two bits are status
+}
+
+} // namespace
+
+uint8_t TwoWire::endTransmission(bool) {
+    if (_address == MUX_ADDR) {
+        if (_txLength > 0) muxMask = _tx[0];
+        return 0;
+    }
+    float tempC, humidity;
+    int ch = openChannel();
+    if (_address != SI7021_ADDR || !sensorAt(ch, tempC, humidity)) return 2;
+    if (_txLength == 0) return 0;
+
+    Si7021 &s = si7021[ch];
+    s.command = _tx[0];
+    if (s.command == 0xF5) {
+        s.readyUs = nowUs + CONVERSION_US;
+        s.rhCode = toCode(constrain(humidity, 0.0f, 100.0f), 6.0f, 125.0f);
+        s.tempCode = toCode(tempC, 46.85f, 175.72f);
+    }
+    return 0;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+    _rxLength = 0;
+    _rxPos = 0;
+    float tempC, humidity;
+    int ch = openChannel();
+    if (address != SI7021_ADDR || !sensorAt(ch, tempC, humidity)) return 0;
+
+    Si7021 &s = si7021[ch];
+    uint16_t code;
+    if (s.command == 0xF5) {
+        if (nowUs < s.readyUs) return 0; // still converting
+        code = s.rhCode;
+    } else if (s.command == 0xE0) {
+        code = s.tempCode;
+    } else if (s.command == 0xE7) {
+        _rx[0] = 0x3A; // user register, reset value
+        _rxLength = 1;
+        return 1;
+    } else {
+        return 0;
+    }
+    _rx[0] = code >> 8;
+    _rx[1] = code & 0xFF;
+    _rx[2] = crc8(_rx, 2);
+    _rxLength = (quantity < 3) ? quantity : 3;
+    return _rxLength;
+}
+
+// ---------------------------------------------------------------------------
+// Simulator controls
+
+namespace sim {
+
+void setSensors(SensorFn fn) { sensorFn = fn; }
+
+void advance(uint32_t ms) {
+    nowUs += (uint64_t)ms * 1000;
+    for (SimTimer *t : timers) {
+        if (t->armed && t->due <= nowUs) {
+            t->armed = false;
+            t->callback(t->arg); // may re-arm itself
+        }
+    }
+}
+
+uint64_t micros64() { return nowUs; }
+
+uint32_t heaterDuty(uint8_t channel) { return channel < LEDC_CHANNELS ? ledcDuty[channel] : 0; }
+
+void serialInput(const char *text) {
+    serialIn.erase(0, serialPos);
+    serialPos = 0;
+    serialIn += text;
+}
+
+void echoSerial(bool on) { serialEcho = on; }
+
+} // namespace sim
@@ -0,0 +1,56 @@
+#ifndef THERMAL_MODEL_H
+#define THERMAL_MODEL_H
+
+#include <math.h>
+
+// Lumped-capacitance model of one enclosure: a single thermal mass (air,
+// walls and heater) losing heat to the room through a single resistance,
+//
+//     C dT/dt = P * duty - (T - T_ambient) / R
+//
+// seen through a sensor that lags the air by a first-order time constant.
+// Relative humidity follows from a fixed moisture content, falling about
+// 6 % (relative) per kelvin of warming. The defaults are rough figures
+// for a printer enclosure with a 150 W heater: ~37 K rise at full power
+// and a time constant of about 40 minutes. Temperatures are degrees C.
+class ThermalZone {
+public:
+    float capacity;    // J/K
+    float resistance;  // K/W to ambient
+    float heaterWatts; // at 100 % duty
+    float sensorTau;   // s
+
+private:
+    float _air;
+    float _sensed;
+
+public:
+    ThermalZone()
+        : capacity(9000.0f), resistance(0.25f), heaterWatts(150.0f), sensorTau(30.0f),
+          _air(22.0f), _sensed(22.0f) {}
+
+    void reset(float ambient) {
+        _air = ambient;
+        _sensed = ambient;
+    }
+
+    // Advance by dt seconds with the heater at `duty` (0-1); explicit Euler
+    // is plenty at sub-second steps against a time constant of minutes
+    void step(float duty, float ambient, float dt) {
+        float watts = heaterWatts * duty - (_air - ambient) / resistance;
+        _air += watts * dt / capacity;
+        _sensed += (_air - _sensed) * dt / (sensorTau + dt);
+    }
+
+    float air() const { return _air; }
+    float sensed() const { return _sensed; }
+
+    float humidity(float ambient, float ambientHumidity) const {
+        return ambientHumidity * powf(0.94f, _sensed - ambient);
+    }
+};
+
+inline float toFahrenheit(float c) { return c * 9.0f / 5.0f + 32.0f; }
+inline float toCelsius(float f) { return (f - 32.0f) * 5.0f / 9.0f; }
+
+#endif // THERMAL_MODEL_H
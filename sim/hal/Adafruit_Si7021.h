@@ -0,0 +1,27 @@
+#ifndef SIM_ADAFRUIT_SI7021_H
+#define SIM_ADAFRUIT_SI7021_H
+
+// The driver's probe only: begin() finds a sensor if the simulator models
+// one on the mux channel that is currently open, after the same 50 ms
+// post-reset wait as the real driver. Measurements go through raw Wire
+// transactions (SensorManager) and never reach this class.
+
+#include <Wire.h>
+
+class Adafruit_Si7021 {
+private:
+    TwoWire *_wire;
+
+public:
+    Adafruit_Si7021(TwoWire *wire = &Wire) : _wire(wire) {}
+
+    bool begin() {
+        _wire->beginTransmission(0x40);
+        _wire->write(0xFE); // reset
+        bool ack = _wire->endTransmission() == 0;
+        delay(50);
+        return ack;
+    }
+};
+
+#endif // SIM_ADAFRUIT_SI7021_H
@@ -0,0 +1,53 @@
+#ifndef SIM_EEPROM_H
+#define SIM_EEPROM_H
+
+// Emulated flash-backed EEPROM: erased (0xFF) at start-up, lost at exit.
+// commits() counts the flash writes a real part would have taken.
+
+#include <Arduino.h>
+
+class EEPROMClass {
+public:
+    static const size_t CAPACITY = 4096;
+
+private:
+    uint8_t _data[CAPACITY];
+    size_t _size;
+    uint32_t _commits;
+
+public:
+    EEPROMClass() : _size(0), _commits(0) { memset(_data, 0xFF, sizeof(_data)); }
+
+    bool begin(size_t size) {
+        if (size > CAPACITY) return false;
+        _size = size;
+        return true;
+    }
+
+    size_t length() const { return _size; }
+    uint8_t read(int address) const { return _data[address]; }
+    void write(int address, uint8_t value) { _data[address] = value; }
+
+    template <typename T>
+    T &get(int address, T &value) const {
+        memcpy(&value, _data + address, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    const T &put(int address, const T &value) {
+        memcpy(_data + address, &value, sizeof(T));
+        return value;
+    }
+
+    bool commit() {
+        _commits++;
+        return true;
+    }
+
+    uint32_t commits() const { return _commits; }
+};
+
+extern EEPROMClass EEPROM;
+
+#endif // SIM_EEPROM_H
@@ -0,0 +1,107 @@
+#ifndef SIM_U8G2LIB_H
+#define SIM_U8G2LIB_H
+
+// Full-buffer U8g2 without a panel. Drawing really changes the 1 KB page
+// buffer (text as a 6-pixel-per-character pattern, not real glyphs), so
+// FrameDiff sees the same dirty rows it would on hardware; transfers are
+// counted in tiles instead of being sent anywhere.
+
+#include <Arduino.h>
+
+typedef uint16_t u8g2_uint_t;
+
+#define U8G2_R0 0
+#define U8X8_PIN_NONE 255
+
+extern const uint8_t u8g2_font_ncenB08_tr[];
+extern const uint8_t u8g2_font_5x7_tr[];
+
+class U8G2 : public Print {
+public:
+    static const uint8_t WIDTH = 128;
+    static const uint8_t HEIGHT = 64;
+    static const uint8_t CHAR_WIDTH = 6;
+
+private:
+    uint8_t _buffer[WIDTH * HEIGHT / 8];
+    int16_t _cursorX;
+    int16_t _cursorY;
+    uint32_t _tiles;
+    bool _asleep;
+
+public:
+    U8G2() : _cursorX(0), _cursorY(0), _tiles(0), _asleep(false) { clearBuffer(); }
+
+    void begin() {}
+    void setBusClock(uint32_t) {}
+    void setI2CAddress(uint8_t) {}
+    void setPowerSave(uint8_t on) { _asleep = on; }
+    void setContrast(uint8_t) {}
+    void setFont(const uint8_t *) {}
+    void setCursor(int x, int y) {
+        _cursorX = x;
+        _cursorY = y;
+    }
+
+    void clearBuffer() { memset(_buffer, 0, sizeof(_buffer)); }
+    void sendBuffer() { _tiles += WIDTH / 8 * HEIGHT / 8; }
+    void updateDisplayArea(uint8_t, uint8_t, uint8_t tw, uint8_t th) { _tiles += tw * th; }
+
+    uint8_t *getBufferPtr() { return _buffer; }
+    uint8_t getBufferTileWidth() const { return WIDTH / 8; }
+    uint8_t getBufferTileHeight() const { return HEIGHT / 8; }
+
+    void drawPixel(int x, int y) {
+        if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT) return;
+        _buffer[(y / 8) * WIDTH + x] |= 1 << (y % 8);
+    }
+
+    void drawHLine(int x, int y, int w) {
+        for (int i = 0; i < w; i++) drawPixel(x + i, y);
+    }
+
+    void drawVLine(int x, int y, int h) {
+        for (int i = 0; i < h; i++) drawPixel(x, y + i);
+    }
+
+    void drawBox(int x, int y, int w, int h) {
+        for (int i = 0; i < h; i++) drawHLine(x, y + i, w);
+    }
+
+    void drawFrame(int x, int y, int w, int h) {
+        drawHLine(x, y, w);
+        drawHLine(x, y + h - 1, w);
+        drawVLine(x, y, h);
+        drawVLine(x + w - 1, y, h);
+    }
+
+    u8g2_uint_t getStrWidth(const char *s) const { return CHAR_WIDTH * strlen(s); }
+
+    u8g2_uint_t drawStr(int x, int y, const char *s) {
+        setCursor(x, y);
+        write(s);
+        return getStrWidth(s);
+    }
+
+    using Print::write;
+    size_t write(uint8_t c) override {
+        for (uint8_t col = 0; col < CHAR_WIDTH - 1; col++) {
+            uint8_t bits = (uint8_t)(c * (col + 3));
+            for (uint8_t row = 0; row < 7; row++)
+                if (bits & (1 << row)) drawPixel(_cursorX + col, _cursorY - 7 + row);
+        }
+        _cursorX += CHAR_WIDTH;
+        return 1;
+    }
+
+    uint32_t tilesSent() const { return _tiles; }
+    bool asleep() const { return _asleep; }
+};
+
+class U8G2_SSD1309_128X64_NONAME2_F_HW_I2C : public U8G2 {
+public:
+    U8G2_SSD1309_128X64_NONAME2_F_HW_I2C(int, int = U8X8_PIN_NONE, int = U8X8_PIN_NONE,
+                                         int = U8X8_PIN_NONE) {}
+};
+
+#endif // SIM_U8G2LIB_H
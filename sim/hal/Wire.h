@@ -0,0 +1,51 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+// I2C master whose transactions go to the devices the simulator models
+// (the TCA9548A and the Si7021s behind it, see SimHal.cpp). Write data is
+// buffered until endTransmission(), as on the real core.
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    static const uint8_t BUFFER_SIZE = 16;
+
+private:
+    uint8_t _address;
+    uint8_t _tx[BUFFER_SIZE];
+    uint8_t _txLength;
+    uint8_t _rx[BUFFER_SIZE];
+    uint8_t _rxLength;
+    uint8_t _rxPos;
+
+public:
+    TwoWire() : _address(0), _txLength(0), _rxLength(0), _rxPos(0) {}
+
+    bool begin(int = -1, int = -1, uint32_t = 0) { return true; }
+    bool end() { return true; }
+    void setTimeOut(uint16_t) {}
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t address) {
+        _address = address;
+        _txLength = 0;
+    }
+
+    size_t write(uint8_t b) {
+        if (_txLength >= BUFFER_SIZE) return 0;
+        _tx[_txLength++] = b;
+        return 1;
+    }
+
+    // 0 = ACK, 2 = address NACK
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity);
+
+    int available() { return _rxLength - _rxPos; }
+    int read() { return (_rxPos < _rxLength) ? _rx[_rxPos++] : -1; }
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
@@ -0,0 +1,21 @@
+#ifndef SIM_DRIVER_LEDC_H
+#define SIM_DRIVER_LEDC_H
+
+// The LEDC calls the heater path makes. Duties land in the thermal model
+// (sim::heaterDuty()); the hpoint only matters on real hardware.
+
+#include <stdint.h>
+#include "esp_timer.h"
+
+typedef enum {
+    LEDC_HIGH_SPEED_MODE,
+    LEDC_LOW_SPEED_MODE
+} ledc_mode_t;
+
+typedef int ledc_channel_t;
+
+esp_err_t ledc_set_duty_with_hpoint(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty, uint32_t hpoint);
+esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty);
+esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel);
+
+#endif // SIM_DRIVER_LEDC_H
@@ -0,0 +1,206 @@
+// Host simulation of the enclosure controller. Runs the firmware's own
+// setup(), control period and UI scheduler against the HAL shims in hal/
+// on a virtual clock, with ThermalZone standing in for each enclosure, and
+// reports how every zone came up to temperature and what the loops cost
+// on this machine. A 48 hour run takes seconds.
+//
+//   pio run -e native
+//   .pio/build/native/program [--hours H] [--ambient F] [--humidity RH]
+//                             [--setpoint F] [--watts W] [--echo] [--cmd LINE]...
+//
+// --setpoint overrides every zone's stored setpoint, --watts the modelled
+// heater power, --cmd queues a console command (e.g. "telemetry text", or
+// "power 128" to halve the heater budget) and --echo copies the firmware's
+// Serial output to stdout.
+//
+// `pio test -e native` links the firmware and the shims into each suite
+// under test/ as well; those bring their own main(), so this file drops out.
+
+#ifndef PIO_UNIT_TESTING
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include <EEPROM.h>
+#include "Scheduler.h"
+#include "SharedState.h"
+#include "RunawayDetector.h"
+#include "Sim.h"
+#include "ThermalModel.h"
+
+#include <chrono>
+#include <string>
+
+// Firmware entry points (src/main.cpp)
+void setup();
+void controlPeriod();
+void sendControlCommand(ControlCommandType type, uint8_t zone, int32_t value);
+extern Scheduler scheduler;
+extern SeqLockSnapshot<ControlSnapshot> controlState;
+extern U8G2_SSD1309_128X64_NONAME2_F_HW_I2C u8g2;
+
+namespace {
+
+// Mirrors the wiring tables in main.cpp: ENC 1 and 2 on mux channels 1 and
+// 2, heated through LEDC 0 and 1; the filament boxes on channels 0 and 3
+const uint8_t CONTROL_PERIOD_MS = 100; // CONTROL_HZ 10
+const uint8_t ZONE_MUX[ZONE_COUNT] = {1, 2};
+const uint8_t ZONE_LEDC[ZONE_COUNT] = {0, 1};
+const uint8_t BOX_MUX[FILAMENT_BOX_COUNT] = {0, 3};
+
+const uint8_t PLANT_STEP_MS = 100;
+const unsigned long SETTLE_MS = 1800000; // steady-state band is measured from here after reaching setpoint
+const float REACHED_BAND_F = 1.0f;
+
+float ambientC = toCelsius(72.0f);
+float ambientHumidity = 40.0f;
+ThermalZone plant[ZONE_COUNT];
+
+bool readSensor(uint8_t channel, float &tempC, float &humidity) {
+    for (uint8_t i = 0; i < ZONE_COUNT; i++) {
+        if (channel == ZONE_MUX[i]) {
+            tempC = plant[i].sensed();
+            humidity = plant[i].humidity(ambientC, ambientHumidity);
+            return true;
+        }
+    }
+    for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++) {
+        if (channel == BOX_MUX[i]) {
+            tempC = ambientC;
+            humidity = ambientHumidity;
+            return true;
+        }
+    }
+    return false;
+}
+
+struct LoopCost {
+    uint64_t calls;
+    uint64_t totalNs;
+    uint64_t maxNs;
+
+    template <typename Fn>
+    void measure(Fn fn) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        calls++;
+        totalNs += ns;
+        if (ns > maxNs) maxNs = ns;
+    }
+
+    void print(const char *name) const {
+        printf("  %-16s %10llu calls  mean %7.2f us  max %8.2f us\n", name, (unsigned long long)calls,
+               calls ? totalNs / 1000.0 / calls : 0.0, maxNs / 1000.0);
+    }
+};
+
+struct ZoneResult {
+    long reachedMs; // -1 = never
+    float overshoot;
+    float settledBand;
+    uint64_t dutySum;
+    uint32_t dutySamples;
+};
+
+void usage() {
+    fprintf(stderr, "usage: program [--hours H] [--ambient F] [--humidity RH] [--setpoint F] [--watts W]"
+                    " [--echo] [--cmd LINE]...\n");
+    exit(2);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    float hours = 48.0f;
+    float setpointF = NAN;
+    float watts = NAN;
+    std::string commands;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--echo") sim::echoSerial(true);
+        else if (!hasValue) usage();
+        else if (arg == "--hours") hours = atof(argv[++i]);
+        else if (arg == "--ambient") ambientC = toCelsius(atof(argv[++i]));
+        else if (arg == "--humidity") ambientHumidity = atof(argv[++i]);
+        else if (arg == "--setpoint") setpointF = atof(argv[++i]);
+        else if (arg == "--watts") watts = atof(argv[++i]);
+        else if (arg == "--cmd") commands += std::string(argv[++i]) + "\n";
+        else usage();
+    }
+
+    for (ThermalZone &z : plant) {
+        if (!isnan(watts)) z.heaterWatts = watts;
+        z.reset(ambientC);
+    }
+    sim::setSensors(readSensor);
+
+    LoopCost setupCost = {}, controlCost = {}, uiCost = {};
+    setupCost.measure(setup);
+    if (!isnan(setpointF)) {
+        for (uint8_t i = 0; i < ZONE_COUNT; i++) sendControlCommand(CMD_SET_SETPOINT, i, lroundf(setpointF * 10));
+    }
+    sim::serialInput(commands.c_str());
+
+    ZoneResult result[ZONE_COUNT] = {};
+    for (ZoneResult &r : result) {
+        r.reachedMs = -1;
+        r.settledBand = 0;
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    const unsigned long endMs = (unsigned long)(hours * 3600000.0f);
+    for (unsigned long ms = 0; ms < endMs; ms++) {
+        sim::advance(1);
+        if (ms % CONTROL_PERIOD_MS == 0) controlCost.measure(controlPeriod);
+        uiCost.measure([] { scheduler.run(); });
+
+        if (ms % PLANT_STEP_MS == 0) {
+            for (uint8_t i = 0; i < ZONE_COUNT; i++)
+                plant[i].step(sim::heaterDuty(ZONE_LEDC[i]) / 255.0f, ambientC, PLANT_STEP_MS / 1000.0f);
+        }
+
+        if (ms % 1000 == 0) {
+            ControlSnapshot snap = controlState.read();
+            for (uint8_t i = 0; i < ZONE_COUNT; i++) {
+                ZoneResult &r = result[i];
+                float error = toFahrenheit(plant[i].air()) - snap.zone[i].setpoint / 10.0f;
+                r.dutySum += snap.zone[i].duty;
+                r.dutySamples++;
+                if (r.reachedMs < 0) {
+                    if (error >= -REACHED_BAND_F) r.reachedMs = ms;
+                    continue;
+                }
+                if (error > r.overshoot) r.overshoot = error;
+                if (ms - r.reachedMs >= SETTLE_MS && fabsf(error) > r.settledBand) r.settledBand = fabsf(error);
+            }
+        }
+    }
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    ControlSnapshot snap = controlState.read();
+    printf("\n%.1f h simulated in %.1f s (ambient %.1f F, %.0f %% RH)\n", hours, wallSeconds, toFahrenheit(ambientC),
+           ambientHumidity);
+    for (uint8_t i = 0; i < ZONE_COUNT; i++) {
+        const ZoneResult &r = result[i];
+        printf("zone %u: setpoint %.1f F, final %.1f F, mean duty %.0f %%, %s\n", i + 1, snap.zone[i].setpoint / 10.0f,
+               toFahrenheit(plant[i].air()), r.dutySamples ? r.dutySum * 100.0 / 255 / r.dutySamples : 0.0,
+               snap.zone[i].fault ? RunawayDetector::describe(snap.zone[i].fault) : (snap.zone[i].heaterOn ? "on" : "off"));
+        if (r.reachedMs < 0) {
+            printf("  setpoint not reached\n");
+            continue;
+        }
+        printf("  time to setpoint %.1f min, overshoot %.2f F", r.reachedMs / 60000.0, r.overshoot);
+        if ((unsigned long)r.reachedMs + SETTLE_MS < endMs) printf(", settled within +/-%.2f F", r.settledBand);
+        printf("\n");
+    }
+    if (snap.overheat) printf("OVERHEAT shutdown\n");
+    printf("host loop cost:\n");
+    setupCost.print("setup");
+    controlCost.print("control period");
+    uiCost.print("ui pass");
+    printf("oled tiles sent %u, eeprom commits %u\n", u8g2.tilesSent(), EEPROM.commits());
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
@@ -0,0 +1,148 @@
+#ifndef BUZZER_H
+#define BUZZER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "Profiler.h"
+
+// Alerts in ascending priority. A higher alert pre-empts a lower one that
+// is playing; a lower one asked for meanwhile either waits its turn or is
+// dropped, depending on its pattern's holdIfBusy.
+enum BuzzerAlert : uint8_t {
+    BUZZ_CLICK,
+    BUZZ_HUMIDITY,
+    BUZZ_FIVE_MIN,
+    BUZZ_TIMER_END,
+    BUZZ_RUNAWAY,
+    BUZZ_ALERT_COUNT
+};
+
+// Alternating ON/OFF durations in ms, starting with ON
+struct BuzzerPattern {
+    const uint16_t *steps;
+    uint8_t length;
+    bool repeat;     // loop until stop()
+    bool holdIfBusy; // play after a higher alert finishes instead of dropping
+};
+
+// Plays patterns in the background from a one-shot esp_timer that re-arms
+// itself for each step, so callers never wait on a beep and nothing has to
+// poll. play()/stop() may be called from any task.
+class Buzzer {
+private:
+    static const uint8_t NONE = 0xFF;
+
+    uint8_t _pin;
+    bool _activeLow;
+    const BuzzerPattern *_patterns; // indexed by BuzzerAlert
+    esp_timer_handle_t _timer;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    uint8_t _current;
+    uint8_t _step;
+    uint8_t _pending; // bit per held BuzzerAlert
+    int64_t _stepEnd; // esp_timer time the current step is due to end
+    LatencyHistogram _stepStats;
+
+    void output(bool on) {
+        digitalWrite(_pin, (on != _activeLow) ? HIGH : LOW);
+    }
+
+    // The helpers below expect the caller to hold _mux
+    void schedule(uint16_t ms) {
+        _stepEnd = esp_timer_get_time() + (int64_t)ms * 1000;
+        esp_timer_start_once(_timer, (uint64_t)ms * 1000);
+    }
+
+    void start(uint8_t alert) {
+        _current = alert;
+        _step = 0;
+        _pending &= ~(1 << alert);
+        output(true);
+        esp_timer_stop(_timer);
+        schedule(_patterns[alert].steps[0]);
+    }
+
+    void startNext() {
+        output(false);
+        _current = NONE;
+        for (int8_t a = BUZZ_ALERT_COUNT - 1; a >= 0; a--) {
+            if (_pending & (1 << a)) {
+                start(a);
+                return;
+            }
+        }
+    }
+
+    static void onTimer(void *arg) {
+        Buzzer *self = static_cast<Buzzer *>(arg);
+        ScopedTimer timer(self->_stepStats);
+        portENTER_CRITICAL(&self->_mux);
+        self->advance();
+        portEXIT_CRITICAL(&self->_mux);
+    }
+
+    void advance() {
+        // A callback that was already dispatched when play()/stop() re-armed
+        // the timer must not cut the new step short.
+        if (_current == NONE || esp_timer_get_time() < _stepEnd) return;
+        const BuzzerPattern &p = _patterns[_current];
+        if (++_step >= p.length) {
+            if (!p.repeat) {
+                startNext();
+                return;
+            }
+            _step = 0;
+        }
+        output(_step % 2 == 0);
+        schedule(p.steps[_step]);
+    }
+
+public:
+    Buzzer(uint8_t pin, bool activeLow, const BuzzerPattern *patterns)
+        : _pin(pin), _activeLow(activeLow), _patterns(patterns), _timer(nullptr),
+          _current(NONE), _step(0), _pending(0), _stepEnd(0) {}
+
+    void begin() {
+        pinMode(_pin, OUTPUT);
+        output(false);
+        esp_timer_create_args_t args = {};
+        args.callback = onTimer;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "buzzer";
+        esp_timer_create(&args, &_timer);
+    }
+
+    void play(BuzzerAlert alert) {
+        portENTER_CRITICAL(&_mux);
+        if (_current == NONE || alert > _current) {
+            start(alert);
+        } else if (alert == _current) {
+            if (!_patterns[alert].repeat) start(alert); // restart a one-shot
+        } else if (_patterns[alert].holdIfBusy) {
+            _pending |= 1 << alert;
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    // Silence an alert, whether it is playing or still waiting its turn
+    void stop(BuzzerAlert alert) {
+        portENTER_CRITICAL(&_mux);
+        _pending &= ~(1 << alert);
+        if (_current == alert) {
+            esp_timer_stop(_timer);
+            startNext();
+        }
+        portEXIT_CRITICAL(&_mux);
+    }
+
+    bool playing(BuzzerAlert alert) const {
+        return _current == alert;
+    }
+
+    // Time spent in each step callback
+    const LatencyHistogram &stepLatency() const { return _stepStats; }
+    void resetStats() { _stepStats.reset(); }
+};
+
+#endif // BUZZER_H
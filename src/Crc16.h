@@ -0,0 +1,18 @@
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <Arduino.h>
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF). Pass the previous result
+// as `crc` to checksum a record in several pieces.
+inline uint16_t crc16(const void *data, size_t len, uint16_t crc = 0xFFFF) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t b = 0; b < 8; b++)
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+    }
+    return crc;
+}
+
+#endif // CRC16_H
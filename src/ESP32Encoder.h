@@ -3,58 +3,115 @@
 
 #include <Arduino.h>
 
+// Quadrature transition table indexed by (oldState << 2) | newState.
+// +1 = forward step, -1 = reverse step, 0 = no movement or invalid jump.
+static constexpr int8_t ENCODER_STEP_TABLE[16] = {
+     0, +1, -1,  0,
+    -1,  0,  0, +1,
+    +1,  0,  0, -1,
+     0, -1, +1,  0
+};
+
 class ESP32Encoder {
+public:
+    static const uint8_t COUNTS_PER_DETENT = 4;
+
+    // Called from the ISR with +1 / -1 for each detent passed
+    typedef void (*DetentFn)(void *arg, int8_t direction);
+
 private:
-    int8_t _oldState;
+    volatile uint8_t _oldState;
     int _pin1, _pin2;
     volatile long _position;
-    
+    volatile long _detent; // position of the last detent reported
+    bool _interruptMode;
+    DetentFn _onDetent;
+    void *_detentArg;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+
+    uint8_t IRAM_ATTR readState() {
+        uint8_t state = 0;
+        if (digitalRead(_pin1)) state |= 1;
+        if (digitalRead(_pin2)) state |= 2;
+        return state;
+    }
+
+    static void IRAM_ATTR isr(void *arg) {
+        ESP32Encoder *self = static_cast<ESP32Encoder *>(arg);
+        portENTER_CRITICAL_ISR(&self->_mux);
+        int8_t detent = self->tick();
+        portEXIT_CRITICAL_ISR(&self->_mux);
+        if (detent && self->_onDetent) self->_onDetent(self->_detentArg, detent);
+    }
+
 public:
     ESP32Encoder(uint8_t pin1, uint8_t pin2) {
         _pin1 = pin1;
         _pin2 = pin2;
         _position = 0;
+        _detent = 0;
         _oldState = 0;
-        
+        _interruptMode = false;
+        _onDetent = nullptr;
+        _detentArg = nullptr;
+
         pinMode(_pin1, INPUT_PULLUP);
         pinMode(_pin2, INPUT_PULLUP);
     }
-    
-    void tick() {
-        int8_t newState = 0;
-        if (digitalRead(_pin1)) newState |= 1;
-        if (digitalRead(_pin2)) newState |= 2;
-        
-        switch (_oldState) {
-            case 0:
-                if (newState == 1) _position++;
-                else if (newState == 2) _position--;
-                break;
-            case 1:
-                if (newState == 3) _position++;
-                else if (newState == 0) _position--;
-                break;
-            case 2:
-                if (newState == 0) _position++;
-                else if (newState == 3) _position--;
-                break;
-            case 3:
-                if (newState == 2) _position++;
-                else if (newState == 1) _position--;
-                break;
-        }
-        
+
+    // Report detents as they happen. Set before attach().
+    void onDetent(DetentFn fn, void *arg) {
+        _onDetent = fn;
+        _detentArg = arg;
+    }
+
+    // Decode every CLK/DT edge from a GPIO change interrupt, so the position
+    // stays exact no matter how long the caller goes between read() calls.
+    void attach() {
+        _oldState = readState();
+        attachInterruptArg(digitalPinToInterrupt(_pin1), isr, this, CHANGE);
+        attachInterruptArg(digitalPinToInterrupt(_pin2), isr, this, CHANGE);
+        _interruptMode = true;
+    }
+
+    void detach() {
+        detachInterrupt(digitalPinToInterrupt(_pin1));
+        detachInterrupt(digitalPinToInterrupt(_pin2));
+        _interruptMode = false;
+    }
+
+    // Decode one sample of the pins. Returns +1 / -1 when that lands on a
+    // detent next to the last one reported: contact bounce around a detent
+    // only rocks the position across its neighbour counts, so it never
+    // reports twice, and a half turn back and forth reports nothing.
+    int8_t IRAM_ATTR tick() {
+        uint8_t newState = readState();
+        _position += ENCODER_STEP_TABLE[(_oldState << 2) | newState];
         _oldState = newState;
+        if (_position == _detent + COUNTS_PER_DETENT) {
+            _detent = _position;
+            return +1;
+        }
+        if (_position == _detent - COUNTS_PER_DETENT) {
+            _detent = _position;
+            return -1;
+        }
+        return 0;
     }
-    
+
     long read() {
-        tick();
+        // Polling fallback when no interrupts are attached; otherwise this is
+        // a single aligned 32-bit load, which is atomic on the ESP32.
+        if (!_interruptMode) tick();
         return _position;
     }
-    
+
     void write(long p) {
+        portENTER_CRITICAL(&_mux);
         _position = p;
+        _detent = p;
+        portEXIT_CRITICAL(&_mux);
     }
 };
 
-#endif // ESP32_ENCODER_H
\ No newline at end of file
+#endif // ESP32_ENCODER_H
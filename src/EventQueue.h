@@ -0,0 +1,120 @@
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <Arduino.h>
+
+// Fixed-capacity min-heap of one-shot events keyed by an absolute millis()
+// deadline. Polling it is a single comparison against the earliest event,
+// so a caller can check it every few milliseconds for free, and every event
+// fires exactly once no matter how late the poll comes.
+//
+// Deadlines are compared by signed difference, which stays correct across
+// the millis() wrap as long as all pending events lie within ~24 days of
+// each other.
+template <uint8_t CAPACITY>
+class EventQueue {
+public:
+    struct Event {
+        unsigned long due;
+        uint8_t owner; // e.g. a zone index, for cancel()
+        uint8_t type;
+    };
+
+private:
+    Event _heap[CAPACITY];
+    uint8_t _count;
+
+    static bool before(const Event &a, const Event &b) {
+        return (long)(a.due - b.due) < 0;
+    }
+
+    void swap(uint8_t a, uint8_t b) {
+        Event t = _heap[a];
+        _heap[a] = _heap[b];
+        _heap[b] = t;
+    }
+
+    void siftUp(uint8_t i) {
+        while (i > 0) {
+            uint8_t parent = (i - 1) / 2;
+            if (!before(_heap[i], _heap[parent])) break;
+            swap(i, parent);
+            i = parent;
+        }
+    }
+
+    void siftDown(uint8_t i) {
+        for (;;) {
+            uint8_t left = 2 * i + 1;
+            uint8_t right = left + 1;
+            uint8_t least = i;
+            if (left < _count && before(_heap[left], _heap[least])) least = left;
+            if (right < _count && before(_heap[right], _heap[least])) least = right;
+            if (least == i) break;
+            swap(i, least);
+            i = least;
+        }
+    }
+
+    void removeAt(uint8_t i) {
+        _heap[i] = _heap[--_count];
+        if (i < _count) {
+            siftDown(i);
+            siftUp(i);
+        }
+    }
+
+    // Keep only events for which `drop` is false, then restore heap order
+    template <typename Pred>
+    void removeIf(Pred drop) {
+        uint8_t kept = 0;
+        for (uint8_t i = 0; i < _count; i++) {
+            if (!drop(_heap[i])) _heap[kept++] = _heap[i];
+        }
+        _count = kept;
+        for (uint8_t i = _count / 2; i-- > 0;) siftDown(i);
+    }
+
+public:
+    EventQueue() : _count(0) {}
+
+    bool schedule(unsigned long dueMs, uint8_t owner, uint8_t type) {
+        if (_count >= CAPACITY) return false;
+        Event &e = _heap[_count];
+        e.due = dueMs;
+        e.owner = owner;
+        e.type = type;
+        siftUp(_count++);
+        return true;
+    }
+
+    // Drop every pending event of `owner`
+    void cancel(uint8_t owner) {
+        removeIf([owner](const Event &e) { return e.owner == owner; });
+    }
+
+    // Drop `owner`'s pending events of one type
+    void cancel(uint8_t owner, uint8_t type) {
+        removeIf([owner, type](const Event &e) { return e.owner == owner && e.type == type; });
+    }
+
+    // Take the earliest event if it is due
+    bool pop(unsigned long nowMs, Event &out) {
+        if (_count == 0 || (long)(nowMs - _heap[0].due) < 0) return false;
+        out = _heap[0];
+        removeAt(0);
+        return true;
+    }
+
+    uint8_t size() const { return _count; }
+    static uint8_t capacity() { return CAPACITY; }
+};
+
+// Whole seconds from nowMs until the millis() deadline dueMs, rounded up,
+// and 0 once it has passed. Same wrap rule as the queue.
+inline unsigned long secondsUntil(unsigned long dueMs, unsigned long nowMs) {
+    long left = (long)(dueMs - nowMs);
+    return left > 0 ? ((unsigned long)left + 999UL) / 1000UL : 0;
+}
+
+#endif // EVENT_QUEUE_H
@@ -0,0 +1,84 @@
+#ifndef FRAME_DIFF_H
+#define FRAME_DIFF_H
+
+#include <Arduino.h>
+#include <U8g2lib.h>
+#include "I2cBus.h"
+#include "Profiler.h"
+
+// Change-driven replacement for u8g2.sendBuffer(). Keeps a shadow copy of
+// the last frame that reached the panel and, on flush(), only transmits the
+// 8-pixel tile rows whose bytes differ (merging adjacent ones into a single
+// updateDisplayArea() call). An unchanged frame costs a 1 KB memcmp and no
+// I2C traffic at all. Each transfer takes the I2C bus lock, so a sensor
+// pass can slip in between changed row runs.
+class FrameDiff {
+public:
+    static const uint16_t MAX_FRAME_BYTES = 1024; // 128x64 monochrome
+
+private:
+    U8G2 &_u8g2;
+    I2cBus &_bus;
+    uint8_t _shadow[MAX_FRAME_BYTES];
+    bool _valid;
+    uint32_t _rowsSent;
+    uint32_t _framesSkipped;
+    LatencyHistogram _flushStats;
+
+public:
+    FrameDiff(U8G2 &u8g2, I2cBus &bus) : _u8g2(u8g2), _bus(bus), _valid(false), _rowsSent(0), _framesSkipped(0) {}
+
+    // Force the next flush() to send the whole frame, e.g. after the panel
+    // was reset, cleared behind our back or woken from power-save.
+    void invalidate() {
+        _valid = false;
+    }
+
+    void flush() {
+        ScopedTimer timer(_flushStats);
+        const uint8_t tileWidth = _u8g2.getBufferTileWidth();
+        const uint8_t tileHeight = _u8g2.getBufferTileHeight();
+        const uint16_t rowBytes = (uint16_t)tileWidth * 8;
+        if ((uint32_t)rowBytes * tileHeight > MAX_FRAME_BYTES) {
+            I2cBus::Guard guard(_bus);
+            _u8g2.sendBuffer();
+            return;
+        }
+
+        const uint8_t *buffer = _u8g2.getBufferPtr();
+        int16_t firstDirty = -1;
+        bool anyDirty = false;
+        for (uint8_t row = 0; row <= tileHeight; row++) {
+            bool dirty = false;
+            if (row < tileHeight) {
+                const uint8_t *src = buffer + row * rowBytes;
+                uint8_t *dst = _shadow + row * rowBytes;
+                dirty = !_valid || memcmp(src, dst, rowBytes) != 0;
+                if (dirty) memcpy(dst, src, rowBytes);
+            }
+            if (dirty) {
+                if (firstDirty < 0) firstDirty = row;
+                anyDirty = true;
+            } else if (firstDirty >= 0) {
+                I2cBus::Guard guard(_bus);
+                _u8g2.updateDisplayArea(0, firstDirty, tileWidth, row - firstDirty);
+                _rowsSent += row - firstDirty;
+                firstDirty = -1;
+            }
+        }
+        if (!anyDirty) _framesSkipped++;
+        _valid = true;
+    }
+
+    uint32_t rowsSent() const { return _rowsSent; }
+    uint32_t framesSkipped() const { return _framesSkipped; }
+    const LatencyHistogram &flushLatency() const { return _flushStats; }
+
+    void resetStats() {
+        _rowsSent = 0;
+        _framesSkipped = 0;
+        _flushStats.reset();
+    }
+};
+
+#endif // FRAME_DIFF_H
@@ -0,0 +1,136 @@
+#ifndef HEATER_CONTROLLER_H
+#define HEATER_CONTROLLER_H
+
+#include <Arduino.h>
+#include <FastPID.h>
+#include "RelayAutoTune.h"
+#include "SharedState.h"
+
+// One zone's heater loop behind a single interface: a PID in normal
+// operation, RelayAutoTune while a tune runs. Takes temperatures in tenths
+// of a degree F and returns an 8-bit LEDC duty, all in integer math; the
+// float gains are only touched when (re)configuring.
+//
+// FastPID supplies the P term. The integral is kept here instead, for two
+// reasons: FastPID only clamps its sum at INT32, so a long warm-up at full
+// power winds it up far past anything the heater can deliver and the zone
+// overshoots by degrees; and its 8.8 fixed point cannot hold the Ki / hz of
+// a slow enclosure at all. Here the sum is Q16 duty, bounded to the output
+// range, and it stops integrating while the output is saturated in the
+// direction the error pushes (conditional integration). The derivative is
+// kept here too: a tuned enclosure's Kd * hz is well past FastPID's 255
+// limit, so it is Q8 duty per tenth of change per step instead.
+//
+// PidGains are expressed per degree F (what the user sees and what gets
+// persisted); they are scaled by 1/INPUT_SCALE for the tenths input.
+class HeaterController {
+public:
+    static const uint8_t OUTPUT_BITS = 8;
+    static const int16_t DUTY_MAX = (1 << OUTPUT_BITS) - 1;
+    static const int16_t INPUT_SCALE = 10;     // controller units per degree F
+    static const int16_t TUNE_HYSTERESIS = 5;  // relay band, tenths of a degree F
+    static constexpr float PARAM_MAX = 255.0f; // FastPID's 8.8 fixed-point limit
+    static const uint8_t I_SHIFT = 16;         // integral fraction bits
+    static const uint8_t D_SHIFT = 8;          // derivative fraction bits
+    static constexpr float PARAM_MIN = 1.0f / 256; // smallest nonzero 8.8 step
+    static const uint8_t KD_WINDOW_S = 60; // Kd ceiling: 0.1 F of drift over this saturates
+
+private:
+    FastPID _pid; // P only, signed 16-bit output
+    RelayAutoTune _tuner;
+    PidGains _gains;
+    uint16_t _hz;
+    int32_t _iStep;    // Q16 duty per tenth of error per step
+    int32_t _integral; // Q16 duty, 0 .. DUTY_MAX
+    int32_t _dStep;    // Q8 duty per tenth of change per step
+    int16_t _lastTemp;
+    bool _primed;      // _lastTemp holds a reading
+
+    bool load(const PidGains &g) {
+        _pid.configure(g.kp / INPUT_SCALE, 0, 0, _hz, 16, true);
+        _iStep = lroundf(g.ki / INPUT_SCALE / _hz * (1L << I_SHIFT));
+        _dStep = lroundf(g.kd / INPUT_SCALE * _hz * (1 << D_SHIFT));
+        if (g.ki > 0 && _iStep == 0) _iStep = 1;
+        if (g.kd > 0 && _dStep == 0) _dStep = 1;
+        reset();
+        return !_pid.err();
+    }
+
+    // P from FastPID, D on the measurement, plus the bounded integral
+    uint8_t pidStep(int16_t setpoint, int16_t temp) {
+        int32_t pd = _pid.step(setpoint, temp);
+        if (_primed) pd -= (int32_t)(((int64_t)temp - _lastTemp) * _dStep >> D_SHIFT);
+        _lastTemp = temp;
+        _primed = true;
+        int32_t error = (int32_t)setpoint - temp;
+        int32_t out = pd + (_integral >> I_SHIFT);
+        bool saturated = (error > 0 && out >= DUTY_MAX) || (error < 0 && out <= 0);
+        if (!saturated) {
+            int64_t sum = _integral + (int64_t)error * _iStep;
+            _integral = (int32_t)constrain(sum, (int64_t)0, (int64_t)DUTY_MAX << I_SHIFT);
+            out = pd + (_integral >> I_SHIFT);
+        }
+        return (uint8_t)constrain(out, (int32_t)0, (int32_t)DUTY_MAX);
+    }
+
+public:
+    HeaterController(uint16_t hz)
+        : _gains(), _hz(hz), _iStep(0), _integral(0), _dStep(0), _lastTemp(0), _primed(false) {}
+
+    // Clamp gains into what can be represented (Kp to FastPID's 8.8 range,
+    // a nonzero one no smaller than its smallest step; Ki and Kd to what
+    // saturates the output) and load them. Returns false, keeping the
+    // previous gains, if FastPID still rejects them.
+    bool configure(PidGains g) {
+        const float scale = INPUT_SCALE;
+        g.kp = g.kp > 0 ? constrain(g.kp, PARAM_MIN * scale, PARAM_MAX * scale) : 0.0f;
+        g.ki = constrain(g.ki, 0.0f, (float)DUTY_MAX * scale * _hz);
+        g.kd = constrain(g.kd, 0.0f, (float)DUTY_MAX * KD_WINDOW_S * scale);
+        if (!load(g)) {
+            load(_gains);
+            return false;
+        }
+        _gains = g;
+        return true;
+    }
+
+    // One control period. A finished tune loads its gains and hands
+    // straight back to the PID in the same step, starting from a clean
+    // integral whatever the outcome; gains that will not load turn the
+    // tune into a FAILED one, so nothing reports or saves them as tuned.
+    uint8_t step(int16_t setpoint, int16_t temp, unsigned long nowMs) {
+        if (_tuner.running()) {
+            uint8_t duty = _tuner.step(temp, nowMs);
+            if (_tuner.running()) return duty;
+            if (_tuner.state() == RelayAutoTune::DONE) {
+                PidGains g = {_tuner.kp() * INPUT_SCALE, _tuner.ki() * INPUT_SCALE,
+                              _tuner.kd() * INPUT_SCALE};
+                if (!configure(g)) _tuner.reject();
+            }
+            reset();
+        }
+        return pidStep(setpoint, temp);
+    }
+
+    // Drop the PID's integral and derivative history, so a zone that is
+    // switched back on does not inherit windup from its last run
+    void reset() {
+        _pid.clear();
+        _integral = 0;
+        _primed = false;
+    }
+
+    void startTune(int16_t setpoint, unsigned long nowMs) {
+        _tuner.start(setpoint, TUNE_HYSTERESIS, nowMs, DUTY_MAX);
+    }
+
+    void abortTune() {
+        _tuner.abort();
+    }
+
+    const PidGains &gains() const { return _gains; }
+    uint8_t tuneState() const { return _tuner.state(); }
+    uint8_t tuneProgress() const { return _tuner.progress(); }
+};
+
+#endif // HEATER_CONTROLLER_H
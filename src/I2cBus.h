@@ -0,0 +1,142 @@
+#ifndef I2C_BUS_H
+#define I2C_BUS_H
+
+#include <Arduino.h>
+#include <Wire.h>
+
+// Owner of the shared I2C bus: the TCA9548A and its Si7021s (control task)
+// and the SSD1309 (UI task). Provides
+//
+//   - a mutex, so the two tasks never interleave transactions
+//   - TCA9548A channel selection that remembers the open channel and only
+//     writes the mux control register when it changes. The OLED sits on the
+//     main bus, so a channel can simply stay open between accesses.
+//   - recovery from a slave holding SDA low: up to 9 SCL pulses and a STOP,
+//     done by hand on the pins, then a fresh Wire.begin()
+//
+// Wire's own timeout bounds a hung transaction; callers report failures
+// through failed(), which recovers the bus once a line is found stuck.
+class I2cBus {
+public:
+    static const uint32_t CLOCK_HZ = 400000;
+    static const uint16_t TIMEOUT_MS = 20;
+    static const uint8_t MUX_ADDR = 0x70;
+    static const uint8_t NO_CHANNEL = 0xFF; // mux state unknown or all closed
+
+    // Holds the bus for the lifetime of a scope. With a wait, gives up
+    // after waitMs if the other task has it; check held() before use.
+    class Guard {
+    private:
+        I2cBus &_bus;
+        bool _held;
+
+    public:
+        Guard(I2cBus &bus) : _bus(bus), _held(true) { _bus.lock(); }
+        Guard(I2cBus &bus, uint32_t waitMs) : _bus(bus), _held(bus.tryLock(waitMs)) {}
+        ~Guard() {
+            if (_held) _bus.unlock();
+        }
+
+        bool held() const { return _held; }
+    };
+
+private:
+    TwoWire &_wire;
+    uint8_t _sda;
+    uint8_t _scl;
+    SemaphoreHandle_t _mutex;
+    uint8_t _channel;
+    uint32_t _switches;
+    uint32_t _recoveries;
+
+    void start() {
+        _wire.begin(_sda, _scl, CLOCK_HZ);
+        _wire.setTimeOut(TIMEOUT_MS);
+        _channel = NO_CHANNEL;
+    }
+
+    bool stuck() const {
+        return digitalRead(_sda) == LOW || digitalRead(_scl) == LOW;
+    }
+
+    // Clock out whatever byte a slave is stuck in, then issue a STOP
+    void releaseLines() {
+        pinMode(_sda, INPUT_PULLUP);
+        pinMode(_scl, OUTPUT_OPEN_DRAIN);
+        digitalWrite(_scl, HIGH);
+        for (uint8_t i = 0; i < 9 && digitalRead(_sda) == LOW; i++) {
+            delayMicroseconds(5);
+            digitalWrite(_scl, LOW);
+            delayMicroseconds(5);
+            digitalWrite(_scl, HIGH);
+        }
+        pinMode(_sda, OUTPUT_OPEN_DRAIN);
+        digitalWrite(_sda, LOW);
+        delayMicroseconds(5);
+        digitalWrite(_sda, HIGH); // SDA rising while SCL is high = STOP
+        delayMicroseconds(5);
+        pinMode(_sda, INPUT_PULLUP);
+        pinMode(_scl, INPUT_PULLUP);
+    }
+
+public:
+    I2cBus(TwoWire &wire, uint8_t sda, uint8_t scl)
+        : _wire(wire), _sda(sda), _scl(scl), _mutex(nullptr), _channel(NO_CHANNEL),
+          _switches(0), _recoveries(0) {}
+
+    // Call once from setup(), before anything else touches the bus. A bus
+    // left stuck by a reset mid-transaction is released first.
+    void begin() {
+        _mutex = xSemaphoreCreateMutex();
+        pinMode(_sda, INPUT_PULLUP);
+        pinMode(_scl, INPUT_PULLUP);
+        if (stuck()) {
+            releaseLines();
+            _recoveries++;
+        }
+        start();
+    }
+
+    void lock() { xSemaphoreTake(_mutex, portMAX_DELAY); }
+    bool tryLock(uint32_t waitMs) { return xSemaphoreTake(_mutex, pdMS_TO_TICKS(waitMs)) == pdTRUE; }
+    void unlock() { xSemaphoreGive(_mutex); }
+
+    // Route the main bus to one mux channel; cheap when it already is.
+    // Caller holds the lock.
+    bool select(uint8_t channel) {
+        if (channel == _channel) return true;
+        _wire.beginTransmission(MUX_ADDR);
+        _wire.write((uint8_t)(1 << channel));
+        if (_wire.endTransmission() != 0) {
+            _channel = NO_CHANNEL;
+            return false;
+        }
+        _channel = channel;
+        _switches++;
+        return true;
+    }
+
+    // Report a failed transaction. An ordinary NACK leaves both lines high
+    // and costs nothing; a stuck line gets the bus torn down and released.
+    // Caller holds the lock. Returns true if a recovery was done.
+    bool failed() {
+        if (!stuck()) return false;
+        _wire.end();
+        releaseLines();
+        start();
+        _recoveries++;
+        return true;
+    }
+
+    TwoWire &wire() { return _wire; }
+    uint8_t channel() const { return _channel; }
+    uint32_t switches() const { return _switches; }
+    uint32_t recoveries() const { return _recoveries; }
+
+    void resetStats() {
+        _switches = 0;
+        _recoveries = 0;
+    }
+};
+
+#endif // I2C_BUS_H
@@ -0,0 +1,195 @@
+#ifndef INPUT_EVENTS_H
+#define INPUT_EVENTS_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+
+// User input as a stream of timestamped events. Producers (the encoder
+// and button interrupts) post into one FreeRTOS queue; the UI task is the
+// only consumer and never looks at raw positions or pin levels.
+
+enum InputEventType : uint8_t {
+    INPUT_STEP,       // one detent, delta = +1 / -1
+    INPUT_FAST_STEP,  // one detent of a fast spin, delta scaled by speed
+    INPUT_CLICK,      // encoder button released before LONG_PRESS_MS
+    INPUT_LONG_PRESS, // encoder button held for LONG_PRESS_MS
+    INPUT_BACK,       // back button pressed
+    INPUT_NONE        // placeholder: a ButtonInput with no hold event
+};
+
+struct InputEvent {
+    InputEventType type;
+    int8_t delta;       // steps for INPUT_STEP / INPUT_FAST_STEP, else 0
+    unsigned long time; // millis() when it happened
+};
+
+// Step size for each detent from the time since the previous one: single
+// steps up to SLOW_MS apart, rising linearly to MAX_STEP at FAST_MS. A
+// change of direction always starts again at a single step, so backing up
+// after overshooting a value is precise.
+class EncoderAcceleration {
+public:
+    static const uint16_t SLOW_MS = 80;
+    static const uint16_t FAST_MS = 15;
+    static const uint8_t MAX_STEP = 10;
+
+private:
+    unsigned long _last;
+    int8_t _direction;
+
+public:
+    EncoderAcceleration() : _last(0), _direction(0) {}
+
+    int8_t IRAM_ATTR step(int8_t direction, unsigned long nowMs) {
+        unsigned long gap = nowMs - _last;
+        bool sameWay = direction == _direction;
+        _last = nowMs;
+        _direction = direction;
+        if (!sameWay || gap >= SLOW_MS) return direction;
+        if (gap <= FAST_MS) return direction * MAX_STEP;
+        uint8_t size = 1 + (uint32_t)(SLOW_MS - gap) * (MAX_STEP - 1) / (SLOW_MS - FAST_MS);
+        return direction * size;
+    }
+};
+
+// The queue itself. Posting never blocks; when the UI falls that far
+// behind, new events are dropped and counted.
+class InputQueue {
+private:
+    QueueHandle_t _queue;
+    volatile uint32_t _dropped;
+
+public:
+    InputQueue() : _queue(nullptr), _dropped(0) {}
+
+    void begin(uint8_t length) {
+        _queue = xQueueCreate(length, sizeof(InputEvent));
+    }
+
+    bool post(InputEventType type, int8_t delta, unsigned long timeMs) {
+        InputEvent e = {type, delta, timeMs};
+        if (xQueueSend(_queue, &e, 0) == pdTRUE) return true;
+        _dropped++;
+        return false;
+    }
+
+    bool IRAM_ATTR postFromISR(InputEventType type, int8_t delta, unsigned long timeMs) {
+        InputEvent e = {type, delta, timeMs};
+        BaseType_t woken = pdFALSE;
+        bool sent = xQueueSendFromISR(_queue, &e, &woken) == pdTRUE;
+        if (!sent) _dropped++;
+        if (woken) portYIELD_FROM_ISR();
+        return sent;
+    }
+
+    bool next(InputEvent &out) {
+        return xQueueReceive(_queue, &out, 0) == pdTRUE;
+    }
+
+    uint32_t dropped() const { return _dropped; }
+    void resetStats() { _dropped = 0; }
+};
+
+// Push button on a GPIO change interrupt, debounced on the leading edge:
+// the first edge of a press or release is acted on at once, then the pin
+// is ignored for DEBOUNCE_MS while the contacts settle, and looked at once
+// more when that window closes in case it changed back inside it. Response
+// is the interrupt latency, not the debounce time.
+//
+// Without a hold event the click is posted on press. With one, a release
+// before LONG_PRESS_MS posts the click and reaching it posts the hold
+// (from a one-shot timer) and swallows the release.
+class ButtonInput {
+public:
+    static const uint8_t DEBOUNCE_MS = 20;
+    static const uint16_t LONG_PRESS_MS = 800;
+
+private:
+    uint8_t _pin;
+    InputQueue &_queue;
+    InputEventType _click;
+    InputEventType _hold;
+    esp_timer_handle_t _settleTimer;
+    esp_timer_handle_t _holdTimer;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+    volatile bool _down;
+    volatile bool _settling;
+    volatile bool _held;
+
+    bool IRAM_ATTR readDown() const { return digitalRead(_pin) == LOW; }
+
+    // Take on a new debounced level; returns the event it causes, if any.
+    // Caller holds _mux.
+    InputEventType IRAM_ATTR change(bool down) {
+        _down = down;
+        _settling = true;
+        esp_timer_start_once(_settleTimer, DEBOUNCE_MS * 1000ULL);
+        if (_hold == INPUT_NONE) return down ? _click : INPUT_NONE;
+        if (down) {
+            _held = false;
+            esp_timer_start_once(_holdTimer, LONG_PRESS_MS * 1000ULL);
+            return INPUT_NONE;
+        }
+        esp_timer_stop(_holdTimer);
+        return _held ? INPUT_NONE : _click;
+    }
+
+    static void IRAM_ATTR onEdge(void *arg) {
+        ButtonInput *self = static_cast<ButtonInput *>(arg);
+        InputEventType e = INPUT_NONE;
+        portENTER_CRITICAL_ISR(&self->_mux);
+        bool down = self->readDown();
+        if (!self->_settling && down != self->_down) e = self->change(down);
+        portEXIT_CRITICAL_ISR(&self->_mux);
+        if (e != INPUT_NONE) self->_queue.postFromISR(e, 0, millis());
+    }
+
+    static void onSettled(void *arg) {
+        ButtonInput *self = static_cast<ButtonInput *>(arg);
+        InputEventType e = INPUT_NONE;
+        portENTER_CRITICAL(&self->_mux);
+        self->_settling = false;
+        bool down = self->readDown();
+        if (down != self->_down) e = self->change(down);
+        portEXIT_CRITICAL(&self->_mux);
+        if (e != INPUT_NONE) self->_queue.post(e, 0, millis());
+    }
+
+    static void onHeld(void *arg) {
+        ButtonInput *self = static_cast<ButtonInput *>(arg);
+        portENTER_CRITICAL(&self->_mux);
+        bool fire = self->_down && !self->_held;
+        self->_held = self->_held || fire;
+        portEXIT_CRITICAL(&self->_mux);
+        if (fire) self->_queue.post(self->_hold, 0, millis());
+    }
+
+    static esp_timer_handle_t makeTimer(esp_timer_cb_t fn, void *arg, const char *name) {
+        esp_timer_create_args_t args = {};
+        args.callback = fn;
+        args.arg = arg;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = name;
+        esp_timer_handle_t timer = nullptr;
+        esp_timer_create(&args, &timer);
+        return timer;
+    }
+
+public:
+    ButtonInput(uint8_t pin, InputQueue &queue, InputEventType click, InputEventType hold = INPUT_NONE)
+        : _pin(pin), _queue(queue), _click(click), _hold(hold), _settleTimer(nullptr), _holdTimer(nullptr),
+          _down(false), _settling(false), _held(false) {}
+
+    // Call from setup() after the queue's begin(); the pin idles HIGH
+    void begin() {
+        pinMode(_pin, INPUT_PULLUP);
+        _settleTimer = makeTimer(onSettled, this, "btn settle");
+        _holdTimer = makeTimer(onHeld, this, "btn hold");
+        _down = readDown();
+        attachInterruptArg(digitalPinToInterrupt(_pin), onEdge, this, CHANGE);
+    }
+
+    bool down() const { return _down; }
+};
+
+#endif // INPUT_EVENTS_H
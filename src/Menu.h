@@ -0,0 +1,96 @@
+#ifndef MENU_H
+#define MENU_H
+
+#include <Arduino.h>
+
+// Descriptor types for the table-driven UI. The screen and item tables are
+// constexpr data in main.cpp (so they live in flash); one generic renderer
+// and one input handler walk them, indexed directly by ScreenId.
+
+// Zone and filament box screens are shared by every zone/box: their
+// descriptors use SLOT_ACTIVE and act on whichever one was picked last.
+enum ScreenId : uint8_t {
+    SCREEN_MAIN,
+    SCREEN_SETTINGS,
+    SCREEN_ZONE,
+    SCREEN_FBOX,
+    SCREEN_ALL_TEMPS,
+    SCREEN_TEMP_TRENDS,
+    SCREEN_HUMIDITY_TRENDS,
+    SCREEN_ZONE_TEMP,
+    SCREEN_ZONE_TIMER,
+    SCREEN_ZONE_COUNTDOWN,
+    SCREEN_ZONE_HUMIDITY,
+    SCREEN_FBOX_HUMIDITY,
+    SCREEN_ZONE_AUTOTUNE,
+    SCREEN_COUNT
+};
+
+enum ScreenKind : uint8_t {
+    SCREEN_KIND_MENU,   // list of MenuItems, encoder moves the cursor
+    SCREEN_KIND_EDITOR, // one ValueEditor, encoder changes the value
+    SCREEN_KIND_VIEW    // read-only page drawn by a render callback
+};
+
+enum ItemKind : uint8_t {
+    ITEM_SCREEN, // target is a ScreenId to open
+    ITEM_ACTION  // target is a MenuAction to run
+};
+
+enum MenuAction : uint8_t {
+    ACTION_SHUT_ALL_OFF,
+    ACTION_AUTOTUNE,
+    ACTION_TOGGLE_MODE,
+    ACTION_VIEW_ZONE,
+    ACTION_TOGGLE_HUMIDITY_ALARM,
+    ACTION_TOGGLE_AUTO_OFF,
+    ACTION_TOGGLE_BEEP
+};
+
+enum EditTarget : uint8_t {
+    EDIT_SETPOINT,      // slot = zone
+    EDIT_TIMER,         // slot = zone
+    EDIT_HUMIDITY_LIMIT // slot = humidity slot
+};
+
+// `slot` selects the zone / humidity slot an item or editor acts on. Zones
+// take humidity slots 0..ZONE_COUNT-1 and the filament boxes follow, so one
+// number identifies either. SLOT_ACTIVE means "the one picked last".
+static const uint8_t SLOT_ACTIVE = 0xFF;
+
+struct MenuItem {
+    const char *label;
+    ItemKind kind;
+    uint8_t target;
+    uint8_t slot;
+};
+
+// value = minValue + index * step, index in [0, count)
+struct ValueEditor {
+    EditTarget target;
+    uint8_t slot;
+    int32_t minValue;
+    uint16_t count;
+    int32_t step;
+    const char *unit;      // nullptr = show as hours/minutes
+    uint8_t confirmScreen; // opened when the encoder button is pressed
+};
+
+struct ScreenDesc {
+    ScreenKind kind;
+    const char *title;
+    uint8_t parent; // opened by the back button
+    const MenuItem *items;
+    uint8_t itemCount;
+    const ValueEditor *editor;
+    void (*render)(uint8_t slot);
+    uint8_t slot;
+};
+
+// Encoder detents -> [0, count), wrapping the same way in both directions
+inline uint16_t wrapIndex(long pos, uint16_t count) {
+    long m = pos % (long)count;
+    return (uint16_t)(m < 0 ? m + count : m);
+}
+
+#endif // MENU_H
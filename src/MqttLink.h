@@ -0,0 +1,115 @@
+#ifndef MQTT_LINK_H
+#define MQTT_LINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <PubSubClient.h>
+
+// Wi-Fi station plus MQTT session for the network task. Everything here may
+// block (TCP connect, DNS, a slow broker), which is why it only ever runs in
+// its own FreeRTOS task and talks to the rest of the firmware through
+// queues and snapshots.
+//
+// Topics live under a base such as "enclosure/esp32-a1b2c3":
+//   <base>/status       "online" / "offline" (retained, last will)
+//   <base>/<sub>        whatever publish() is given
+//   <base>/cmd/...      delivered to the handler with the "cmd/" prefix kept
+//
+// A dropped broker connection is retried with exponential backoff; Wi-Fi
+// reconnects are left to the ESP32 station's auto-reconnect.
+class MqttLink {
+public:
+    typedef void (*Handler)(const char *subtopic, const char *payload);
+
+    static const uint16_t BUFFER_SIZE = 768;
+    static const uint8_t TOPIC_MAX = 64;
+    static const uint8_t PAYLOAD_MAX = 32; // commands are short
+    static const unsigned long RETRY_MIN_MS = 1000;
+    static const unsigned long RETRY_MAX_MS = 60000;
+
+private:
+    WiFiClient _net;
+    PubSubClient _mqtt;
+    Handler _handler;
+    char _base[TOPIC_MAX / 2];
+    char _clientId[24];
+    char _topic[TOPIC_MAX];
+    unsigned long _lastAttempt;
+    unsigned long _retryMs;
+    uint32_t _reconnects;
+
+    const char *topic(const char *sub) {
+        snprintf(_topic, sizeof(_topic), "%s/%s", _base, sub);
+        return _topic;
+    }
+
+    void receive(char *fullTopic, uint8_t *payload, unsigned int len) {
+        size_t baseLen = strlen(_base);
+        if (!_handler || strncmp(fullTopic, _base, baseLen) != 0 || fullTopic[baseLen] != '/') return;
+        char text[PAYLOAD_MAX + 1];
+        if (len > PAYLOAD_MAX) len = PAYLOAD_MAX;
+        memcpy(text, payload, len);
+        text[len] = '\0';
+        _handler(fullTopic + baseLen + 1, text);
+    }
+
+    void reconnect(unsigned long nowMs) {
+        if (nowMs - _lastAttempt < _retryMs) return;
+        _lastAttempt = nowMs;
+        if (_mqtt.connect(_clientId, nullptr, nullptr, topic("status"), 0, true, "offline")) {
+            _retryMs = RETRY_MIN_MS;
+            _reconnects++;
+            _mqtt.publish(topic("status"), "online", true);
+            _mqtt.subscribe(topic("cmd/#"));
+        } else if (_retryMs < RETRY_MAX_MS) {
+            _retryMs = min(_retryMs * 2, RETRY_MAX_MS);
+        }
+    }
+
+public:
+    MqttLink()
+        : _mqtt(_net), _handler(nullptr), _lastAttempt(0), _retryMs(RETRY_MIN_MS), _reconnects(0) {
+        _base[0] = '\0';
+        _clientId[0] = '\0';
+    }
+
+    // Start the station and configure the broker. The client ID and the
+    // topic base both end in the low half of the MAC, so several boxes can
+    // share one broker with the same firmware image.
+    void begin(const char *ssid, const char *password, const char *host, uint16_t port,
+               const char *baseTopic, Handler handler) {
+        uint8_t mac[6];
+        WiFi.mode(WIFI_STA);
+        WiFi.setAutoReconnect(true);
+        WiFi.begin(ssid, password);
+        WiFi.macAddress(mac);
+        snprintf(_clientId, sizeof(_clientId), "esp32-%02x%02x%02x", mac[3], mac[4], mac[5]);
+        snprintf(_base, sizeof(_base), "%s/%s", baseTopic, _clientId);
+
+        _handler = handler;
+        _mqtt.setServer(host, port);
+        _mqtt.setBufferSize(BUFFER_SIZE);
+        _mqtt.setSocketTimeout(2);
+        _mqtt.setCallback([this](char *t, uint8_t *p, unsigned int n) { receive(t, p, n); });
+    }
+
+    // Keep the session alive and dispatch incoming commands; call often
+    void service(unsigned long nowMs) {
+        if (WiFi.status() != WL_CONNECTED) return;
+        if (!_mqtt.connected()) {
+            reconnect(nowMs);
+            if (!_mqtt.connected()) return;
+        }
+        _mqtt.loop();
+    }
+
+    bool connected() { return WiFi.status() == WL_CONNECTED && _mqtt.connected(); }
+
+    bool publish(const char *sub, const char *payload, bool retained = false) {
+        return _mqtt.connected() && _mqtt.publish(topic(sub), payload, retained);
+    }
+
+    uint32_t reconnects() const { return _reconnects; }
+};
+
+#endif // MQTT_LINK_H
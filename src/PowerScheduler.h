@@ -0,0 +1,80 @@
+#ifndef POWER_SCHEDULER_H
+#define POWER_SCHEDULER_H
+
+#include <Arduino.h>
+
+// Shares one supply between the zone heaters. Each control period the
+// zones' PID outputs are granted against a total budget in duty counts
+// (256 = one heater fully on); when demand exceeds it, zones are served in
+// order of how far they are below setpoint, with tuning zones first so a
+// relay tune keeps its full amplitude.
+//
+// Grants are also laid out end to end within the PWM period through the
+// LEDC hpoint, so with a budget of one period the heaters' on-times never
+// overlap and the peak current is that of a single heater. All zones must
+// share one LEDC timer for the phases to line up.
+template <uint8_t ZONES>
+class PowerScheduler {
+public:
+    static const uint16_t PERIOD = 256; // counts per PWM period at 8-bit resolution
+
+    struct Demand {
+        uint8_t duty;    // what the PID asked for
+        int16_t deficit; // setpoint - temperature
+        bool priority;   // served before everything else (auto-tune)
+    };
+
+    struct Grant {
+        uint8_t duty;
+        uint16_t hpoint; // counter value at which the output goes high
+    };
+
+private:
+    uint16_t _budget;
+    uint32_t _limited; // periods in which some demand was cut
+
+    static bool ahead(const Demand &a, const Demand &b) {
+        if (a.priority != b.priority) return a.priority;
+        return a.deficit > b.deficit;
+    }
+
+public:
+    PowerScheduler(uint16_t budget) : _budget(budget), _limited(0) {}
+
+    void setBudget(uint16_t budget) { _budget = budget; }
+    uint16_t budget() const { return _budget; }
+
+    void allocate(const Demand *demand, Grant *grant) {
+        uint8_t order[ZONES];
+        for (uint8_t i = 0; i < ZONES; i++) {
+            uint8_t j = i;
+            for (; j > 0 && ahead(demand[i], demand[order[j - 1]]); j--) order[j] = order[j - 1];
+            order[j] = i;
+        }
+
+        uint16_t remaining = _budget;
+        uint16_t offset = 0;
+        bool limited = false;
+        for (uint8_t k = 0; k < ZONES; k++) {
+            uint8_t i = order[k];
+            uint8_t duty = demand[i].duty;
+            if (duty > remaining) {
+                duty = remaining;
+                limited = true;
+            }
+            remaining -= duty;
+
+            uint16_t hpoint = offset % PERIOD;
+            if (hpoint + duty > PERIOD) hpoint = PERIOD - duty; // only once over one period
+            grant[i].duty = duty;
+            grant[i].hpoint = hpoint;
+            offset += duty;
+        }
+        if (limited) _limited++;
+    }
+
+    uint32_t limitedPeriods() const { return _limited; }
+    void resetStats() { _limited = 0; }
+};
+
+#endif // POWER_SCHEDULER_H
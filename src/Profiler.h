@@ -0,0 +1,92 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+
+// Fixed-size latency histogram in microseconds. Bucket b holds samples
+// below 2^b us (bucket 0 is exactly 0 us), so 24 buckets cover up to ~8 s
+// in 96 bytes. Recording is a handful of integer ops, cheap enough to leave
+// on in production firmware.
+//
+// Each histogram must have a single writer (one task). Readers on the
+// other core may see a sample half-recorded; the numbers are diagnostics,
+// not control inputs, so that is accepted rather than locked against.
+class LatencyHistogram {
+public:
+    static const uint8_t BUCKETS = 24;
+
+private:
+    uint32_t _buckets[BUCKETS];
+    uint32_t _count;
+    uint64_t _sumUs;
+    uint32_t _minUs;
+    uint32_t _maxUs;
+
+    static uint8_t bucketOf(uint32_t us) {
+        if (us == 0) return 0;
+        uint8_t b = 32 - __builtin_clz(us);
+        return b < BUCKETS ? b : BUCKETS - 1;
+    }
+
+public:
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(_buckets, 0, sizeof(_buckets));
+        _count = 0;
+        _sumUs = 0;
+        _minUs = UINT32_MAX;
+        _maxUs = 0;
+    }
+
+    void record(uint32_t us) {
+        _buckets[bucketOf(us)]++;
+        _count++;
+        _sumUs += us;
+        if (us < _minUs) _minUs = us;
+        if (us > _maxUs) _maxUs = us;
+    }
+
+    void recordSince(int64_t startUs) {
+        record((uint32_t)(esp_timer_get_time() - startUs));
+    }
+
+    uint32_t count() const { return _count; }
+    uint32_t minUs() const { return _count ? _minUs : 0; }
+    uint32_t maxUs() const { return _maxUs; }
+    uint32_t avgUs() const { return _count ? (uint32_t)(_sumUs / _count) : 0; }
+
+    // Upper bound of the bucket holding the 99th percentile, capped at max
+    uint32_t p99Us() const {
+        uint32_t tail = _count / 100;
+        uint32_t seen = 0;
+        for (int8_t b = BUCKETS - 1; b > 0; b--) {
+            seen += _buckets[b];
+            if (seen > tail) {
+                uint32_t upper = (1UL << b) - 1;
+                return upper < _maxUs ? upper : _maxUs;
+            }
+        }
+        return 0;
+    }
+
+    void print(Print &out, const char *label) const {
+        out.printf("%-12s n=%lu min=%lu avg=%lu p99<=%lu max=%lu us\n", label,
+                   (unsigned long)count(), (unsigned long)minUs(), (unsigned long)avgUs(),
+                   (unsigned long)p99Us(), (unsigned long)maxUs());
+    }
+};
+
+// Times a scope into a histogram: { ScopedTimer t(pidStats); ... }
+class ScopedTimer {
+private:
+    LatencyHistogram &_hist;
+    int64_t _start;
+
+public:
+    ScopedTimer(LatencyHistogram &hist) : _hist(hist), _start(esp_timer_get_time()) {}
+    ~ScopedTimer() { _hist.recordSince(_start); }
+};
+
+#endif // PROFILER_H
@@ -0,0 +1,93 @@
+#ifndef RECORD_RING_H
+#define RECORD_RING_H
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include "Crc16.h"
+
+// SLOTS versioned, CRC-checked copies of a plain struct T in EEPROM, each
+// stamped with a sequence number. write() replaces the oldest copy and
+// load() returns the newest valid one, so a record that fails its CRC
+// falls back to the one written before it.
+//
+// More slots buy nothing for wear: on ESP32 the EEPROM library is a RAM
+// buffer that EEPROM.commit() writes to NVS as a single blob, so every
+// write costs the same whatever slot it lands in. What wears flash is the
+// number of commits, which the stores built on this keep down.
+template <typename T, uint8_t SLOTS, uint16_t MAGIC>
+class RecordRing {
+    static_assert(sizeof(T) <= 255, "RecordRing payload too large for Record::size");
+
+    struct Record {
+        uint16_t magic;
+        uint8_t version;
+        uint8_t size;
+        uint32_t sequence;
+        T data;
+        uint16_t crc;
+    };
+
+    int _base;
+    uint8_t _version;
+    uint8_t _slot;
+    uint32_t _sequence;
+    uint32_t _commits;
+
+    int slotAddress(uint8_t slot) const {
+        return _base + slot * (int)sizeof(Record);
+    }
+
+    static uint16_t recordCrc(const Record &rec) {
+        return crc16(&rec, offsetof(Record, crc));
+    }
+
+public:
+    static const int STORAGE_BYTES = SLOTS * sizeof(Record);
+
+    RecordRing(int baseAddress, uint8_t version)
+        : _base(baseAddress), _version(version), _slot(SLOTS - 1), _sequence(0), _commits(0) {}
+
+    // Call after EEPROM.begin(). Copies the newest valid record for this
+    // version into `out` and returns true; `out` is left alone otherwise.
+    // Later writes continue after the record found.
+    bool load(T &out) {
+        bool found = false;
+        for (uint8_t slot = 0; slot < SLOTS; slot++) {
+            Record rec;
+            EEPROM.get(slotAddress(slot), rec);
+            if (rec.magic != MAGIC || rec.version != _version || rec.size != sizeof(T)) continue;
+            if (rec.crc != recordCrc(rec)) continue;
+            if (found && (int32_t)(rec.sequence - _sequence) <= 0) continue;
+            found = true;
+            _slot = slot;
+            _sequence = rec.sequence;
+            out = rec.data;
+        }
+        return found;
+    }
+
+    // Write `data` over the oldest slot and commit
+    void write(const T &data) {
+        Record rec;
+        memset(&rec, 0, sizeof(rec)); // deterministic padding for the CRC
+        rec.magic = MAGIC;
+        rec.version = _version;
+        rec.size = sizeof(T);
+        rec.sequence = _sequence + 1;
+        rec.data = data;
+        rec.crc = recordCrc(rec);
+
+        uint8_t slot = (_slot + 1) % SLOTS;
+        EEPROM.put(slotAddress(slot), rec);
+        EEPROM.commit();
+
+        _slot = slot;
+        _sequence = rec.sequence;
+        _commits++;
+    }
+
+    uint32_t sequence() const { return _sequence; }
+    uint32_t commits() const { return _commits; }
+};
+
+#endif // RECORD_RING_H
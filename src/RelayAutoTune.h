@@ -0,0 +1,133 @@
+#ifndef RELAY_AUTO_TUNE_H
+#define RELAY_AUTO_TUNE_H
+
+#include <Arduino.h>
+
+// Non-blocking Åström–Hägglund relay auto-tuner. While running, step()
+// replaces the PID: it bang-bangs the heater between 0 and `high` around
+// the setpoint with a small hysteresis, which drives the enclosure into a
+// steady limit cycle. The period Tu and amplitude a of that oscillation
+// give the ultimate gain Ku = 4d / (pi * a), with d the relay amplitude,
+// and the gains follow from Ziegler–Nichols' "no overshoot" rule
+// (Kp = 0.2 Ku, Ti = Tu / 2, Td = Tu / 3), since overshoot is what the
+// hard-coded gains got wrong.
+//
+// The first full oscillation still carries the warm-up and is discarded;
+// the next MEASURED_CYCLES are averaged. Temperatures are integers in
+// whatever fixed-point unit the caller's controller uses, and the gains
+// come out per that unit; floats are only used once, in finish().
+class RelayAutoTune {
+public:
+    enum State : uint8_t {
+        IDLE,
+        RUNNING,
+        DONE,
+        FAILED
+    };
+
+    static const uint8_t MEASURED_CYCLES = 4;
+    static const unsigned long TIMEOUT_MS = 4UL * 3600UL * 1000UL;
+
+private:
+    State _state;
+    int16_t _setpoint;
+    int16_t _hysteresis;
+    uint8_t _high;
+    bool _relayOn;
+    unsigned long _start;
+    unsigned long _lastRise;
+    uint8_t _rises;
+    int16_t _peakHigh;
+    int16_t _peakLow;
+    uint32_t _sumPeriodMs;
+    int32_t _sumPeakToPeak;
+    float _kp, _ki, _kd;
+
+    void finish() {
+        uint8_t n = MEASURED_CYCLES;
+        float amplitude = (float)_sumPeakToPeak / n / 2;
+        float tu = (float)_sumPeriodMs / n / 1000.0f;
+        if (amplitude <= 0 || tu <= 0) {
+            _state = FAILED;
+            return;
+        }
+        float ku = 4.0f * (_high / 2.0f) / (PI * amplitude);
+        _kp = 0.2f * ku;
+        _ki = _kp / (tu / 2);
+        _kd = _kp * tu / 3;
+        _state = DONE;
+    }
+
+public:
+    RelayAutoTune()
+        : _state(IDLE), _setpoint(0), _hysteresis(0), _high(0), _relayOn(false),
+          _start(0), _lastRise(0), _rises(0), _peakHigh(0), _peakLow(0),
+          _sumPeriodMs(0), _sumPeakToPeak(0), _kp(0), _ki(0), _kd(0) {}
+
+    void start(int16_t setpoint, int16_t hysteresis, unsigned long nowMs, uint8_t high = 255) {
+        _state = RUNNING;
+        _setpoint = setpoint;
+        _hysteresis = hysteresis;
+        _high = high;
+        _relayOn = true;
+        _start = nowMs;
+        _rises = 0;
+        _sumPeriodMs = 0;
+        _sumPeakToPeak = 0;
+    }
+
+    void abort() {
+        if (_state == RUNNING) _state = IDLE;
+    }
+
+    // The caller could not use the gains of a finished tune
+    void reject() {
+        if (_state == DONE) _state = FAILED;
+    }
+
+    // Feed one temperature sample; returns the heater duty to apply
+    uint8_t step(int16_t temp, unsigned long nowMs) {
+        if (_state != RUNNING) return 0;
+        if (nowMs - _start > TIMEOUT_MS) {
+            _state = FAILED;
+            return 0;
+        }
+
+        if (temp > _peakHigh) _peakHigh = temp;
+        if (temp < _peakLow) _peakLow = temp;
+
+        if (_relayOn && temp > _setpoint + _hysteresis) {
+            _relayOn = false;
+        } else if (!_relayOn && temp < _setpoint - _hysteresis) {
+            // A rising switch closes one full oscillation
+            _relayOn = true;
+            _rises++;
+            if (_rises > 2) {
+                _sumPeriodMs += nowMs - _lastRise;
+                _sumPeakToPeak += _peakHigh - _peakLow;
+            }
+            _lastRise = nowMs;
+            _peakHigh = _peakLow = temp;
+            if (_rises >= MEASURED_CYCLES + 2) {
+                finish();
+                return 0;
+            }
+        }
+        return _relayOn ? _high : 0;
+    }
+
+    State state() const { return _state; }
+    bool running() const { return _state == RUNNING; }
+
+    // Rough completion in percent, counted in relay cycles
+    uint8_t progress() const {
+        if (_state == DONE) return 100;
+        return (uint8_t)(_rises * 100 / (MEASURED_CYCLES + 2));
+    }
+
+    float kp() const { return _kp; }
+    float ki() const { return _ki; }
+    float kd() const { return _kd; }
+};
+
+#endif // RELAY_AUTO_TUNE_H
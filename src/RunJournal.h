@@ -0,0 +1,64 @@
+#ifndef RUN_JOURNAL_H
+#define RUN_JOURNAL_H
+
+#include <Arduino.h>
+#include "RecordRing.h"
+
+// Journal of a run-state struct T in EEPROM, so a job in progress survives
+// a reset or brown-out. Records go through a RecordRing of SLOTS, so a
+// corrupted one falls back to the state journalled before it.
+//
+// Appends are batched: the first one opens a window and anything appended
+// inside it replaces the staged record, so a burst of changes costs one
+// commit when service() closes the window.
+template <typename T, uint8_t SLOTS>
+class RunJournal {
+public:
+    static const uint16_t MAGIC = 0x4A52; // "RJ"
+
+private:
+    typedef RecordRing<T, SLOTS, MAGIC> Ring;
+
+    Ring _ring;
+    T _staged;
+    bool _pending;
+    unsigned long _stagedAt;
+
+public:
+    static const int STORAGE_BYTES = Ring::STORAGE_BYTES;
+
+    RunJournal(int baseAddress, uint8_t version)
+        : _ring(baseAddress, version), _staged(), _pending(false), _stagedAt(0) {}
+
+    // Call after EEPROM.begin(). Loads the newest journalled state into
+    // `out` and returns true if there was a valid one for this version;
+    // `out` is left alone otherwise.
+    bool begin(T &out) {
+        _pending = false;
+        return _ring.load(out);
+    }
+
+    // Stage a record; it reaches flash when the batch window closes
+    void append(const T &data) {
+        if (!_pending) _stagedAt = millis();
+        _staged = data;
+        _pending = true;
+    }
+
+    bool pending() const { return _pending; }
+    uint32_t commits() const { return _ring.commits(); }
+    uint32_t sequence() const { return _ring.sequence(); }
+
+    // Commit the staged record once it has waited batchMs
+    void service(unsigned long batchMs) {
+        if (_pending && millis() - _stagedAt >= batchMs) flush();
+    }
+
+    void flush() {
+        if (!_pending) return;
+        _pending = false;
+        _ring.write(_staged);
+    }
+};
+
+#endif // RUN_JOURNAL_H
@@ -0,0 +1,122 @@
+#ifndef RUNAWAY_DETECTOR_H
+#define RUNAWAY_DETECTOR_H
+
+#include <Arduino.h>
+
+// Per-zone thermal protection in the style of printer firmware, checked
+// every control period before the PID output is applied:
+//
+//   stale      no fresh sensor sample for STALE_MS (dead or unplugged)
+//   rise rate  warmer over RATE_WINDOW_MS than the heater could explain:
+//              RISE_SLACK plus MAX_RISE scaled by the window's mean duty
+//   no heat    driven at WATCH_DUTY or more while below setpoint, but not
+//              WATCH_RISE warmer after WATCH_MS (heater or sensor detached)
+//
+// A fault latches until reset(), so the heater stays off even if the
+// condition clears on its own. The hard overheat limit stays with the
+// caller, which shuts every zone down. Temperatures are tenths of a degree F.
+class RunawayDetector {
+public:
+    enum Fault : uint8_t {
+        FAULT_NONE,
+        FAULT_STALE,
+        FAULT_RISE_RATE,
+        FAULT_NO_HEAT
+    };
+
+    static const unsigned long STALE_MS = 3000;
+    static const unsigned long RATE_WINDOW_MS = 30000;
+    static const int16_t RISE_SLACK = 20; // ambient drift and sensor noise per window
+    static const int16_t MAX_RISE = 50;   // per window at full duty
+    static const unsigned long WATCH_MS = 300000;
+    static const int16_t WATCH_RISE = 10;
+    static const int16_t WATCH_BAND = 30; // only watched this far below setpoint
+    static const uint8_t WATCH_DUTY = 128;
+
+private:
+    Fault _fault;
+    bool _started;
+    unsigned long _armedAt;
+
+    unsigned long _rateStart;
+    int16_t _rateTemp;
+    uint32_t _dutySum;
+    uint16_t _dutySteps;
+
+    bool _watching;
+    unsigned long _watchStart;
+    int16_t _watchTemp;
+
+    void restartRate(int16_t temp, unsigned long nowMs) {
+        _rateStart = nowMs;
+        _rateTemp = temp;
+        _dutySum = 0;
+        _dutySteps = 0;
+    }
+
+    Fault check(int16_t temp, unsigned long sampleMs, int16_t setpoint, uint8_t duty, unsigned long nowMs) {
+        if (nowMs - (sampleMs ? sampleMs : _armedAt) > STALE_MS) return FAULT_STALE;
+        if (sampleMs == 0) return FAULT_NONE; // nothing measured yet
+
+        if (!_started) {
+            _started = true;
+            restartRate(temp, nowMs);
+        }
+        _dutySum += duty;
+        _dutySteps++;
+        if (nowMs - _rateStart >= RATE_WINDOW_MS) {
+            int32_t allowed = RISE_SLACK + (int32_t)MAX_RISE * (_dutySum / _dutySteps) / 255;
+            if (temp - _rateTemp > allowed) return FAULT_RISE_RATE;
+            restartRate(temp, nowMs);
+        }
+
+        if (duty >= WATCH_DUTY && temp < setpoint - WATCH_BAND) {
+            if (!_watching) {
+                _watching = true;
+                _watchStart = nowMs;
+                _watchTemp = temp;
+            } else if (temp >= _watchTemp + WATCH_RISE) {
+                _watchStart = nowMs;
+                _watchTemp = temp;
+            } else if (nowMs - _watchStart >= WATCH_MS) {
+                return FAULT_NO_HEAT;
+            }
+        } else {
+            _watching = false;
+        }
+        return FAULT_NONE;
+    }
+
+public:
+    RunawayDetector() : _fault(FAULT_NONE), _started(false), _armedAt(0), _rateStart(0), _rateTemp(0),
+                        _dutySum(0), _dutySteps(0), _watching(false), _watchStart(0), _watchTemp(0) {}
+
+    // Clear a latched fault and start watching afresh from `nowMs`
+    void reset(unsigned long nowMs) {
+        _fault = FAULT_NONE;
+        _started = false;
+        _armedAt = nowMs;
+        _watching = false;
+    }
+
+    // One control period. `sampleMs` is when `temp` was measured (0 =
+    // never) and `duty` what the heater was driven at since the last call.
+    // Returns true while the zone is faulted and its heater must stay off.
+    bool step(int16_t temp, unsigned long sampleMs, int16_t setpoint, uint8_t duty, unsigned long nowMs) {
+        if (_fault == FAULT_NONE) _fault = check(temp, sampleMs, setpoint, duty, nowMs);
+        return _fault != FAULT_NONE;
+    }
+
+    Fault fault() const { return _fault; }
+
+    static const char *describe(uint8_t fault) {
+        switch (fault) {
+        case FAULT_STALE: return "SENSOR LOST";
+        case FAULT_RISE_RATE: return "RUNAWAY";
+        case FAULT_NO_HEAT: return "NOT HEATING";
+        }
+        return "OK";
+    }
+};
+
+#endif // RUNAWAY_DETECTOR_H
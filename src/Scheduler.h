@@ -0,0 +1,52 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <Arduino.h>
+
+// Cooperative millis()-deadline scheduler. Each task runs once its deadline
+// has passed and is then re-armed one interval later, so slow tasks only
+// delay their neighbours by their own run time instead of a fixed delay().
+class Scheduler {
+public:
+    typedef void (*TaskFn)();
+    static const uint8_t MAX_TASKS = 12;
+
+private:
+    struct Task {
+        TaskFn fn;
+        unsigned long interval;
+        unsigned long nextRun;
+    };
+
+    Task _tasks[MAX_TASKS];
+    uint8_t _count;
+
+public:
+    Scheduler() : _count(0) {}
+
+    bool add(TaskFn fn, unsigned long intervalMs, unsigned long offsetMs = 0) {
+        if (_count >= MAX_TASKS) return false;
+        _tasks[_count].fn = fn;
+        _tasks[_count].interval = intervalMs;
+        _tasks[_count].nextRun = millis() + offsetMs;
+        _count++;
+        return true;
+    }
+
+    void run() {
+        for (uint8_t i = 0; i < _count; i++) {
+            Task &t = _tasks[i];
+            unsigned long now = millis();
+            // Signed difference keeps the comparison valid across millis() wrap.
+            if ((long)(now - t.nextRun) < 0) continue;
+
+            t.nextRun += t.interval;
+            // If we fell more than a whole period behind, drop the missed runs
+            // instead of firing them back to back.
+            if ((long)(now - t.nextRun) >= 0) t.nextRun = now + t.interval;
+            t.fn();
+        }
+    }
+};
+
+#endif // SCHEDULER_H
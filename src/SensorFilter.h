@@ -0,0 +1,112 @@
+#ifndef SENSOR_FILTER_H
+#define SENSOR_FILTER_H
+
+#include <Arduino.h>
+
+// Conditioning for one fixed-point sensor value between acquisition and
+// the PID:
+//
+//   1. range check: a code outside what the sensor can report is dropped
+//   2. step check: a jump of more than maxStep from the filtered value is
+//      held back as an outlier; REJECT_LIMIT of them in a row are taken as
+//      a real change of level and the filter is re-seeded there
+//   3. median of the last WINDOW accepted samples
+//   4. first-order IIR (EMA, alpha = 1 / 2^EMA_SHIFT) over the median,
+//      kept with FRAC_BITS extra bits so small steps are not lost
+//
+// health() is a 0-100 score that rises with accepted samples and falls
+// with rejected or missing ones. All state is static and integer; add()
+// is a few dozen instructions.
+class SensorFilter {
+public:
+    static const uint8_t WINDOW = 5;
+    static const uint8_t EMA_SHIFT = 2;
+    static const uint8_t FRAC_BITS = 4;
+    static const uint8_t REJECT_LIMIT = 3;
+    static const uint8_t HEALTH_SHIFT = 3; // health moves 1/8 of the way per sample
+
+private:
+    int16_t _min;
+    int16_t _max;
+    int16_t _maxStep;
+
+    int16_t _window[WINDOW];
+    uint8_t _head;
+    uint8_t _count;
+    int32_t _ema; // value << FRAC_BITS
+    uint8_t _rejects;
+    uint8_t _health;
+    uint32_t _outliers;
+
+    int16_t median() const {
+        int16_t sorted[WINDOW];
+        for (uint8_t i = 0; i < _count; i++) {
+            int16_t v = _window[i];
+            uint8_t j = i;
+            for (; j > 0 && sorted[j - 1] > v; j--) sorted[j] = sorted[j - 1];
+            sorted[j] = v;
+        }
+        return sorted[_count / 2];
+    }
+
+    void seed(int16_t v) {
+        _count = 0;
+        _head = 0;
+        _ema = (int32_t)v << FRAC_BITS;
+    }
+
+    void good() {
+        _health += (100 - _health + (1 << HEALTH_SHIFT) - 1) >> HEALTH_SHIFT;
+    }
+
+public:
+    SensorFilter(int16_t minValid, int16_t maxValid, int16_t maxStep)
+        : _min(minValid), _max(maxValid), _maxStep(maxStep), _head(0), _count(0), _ema(0),
+          _rejects(0), _health(0), _outliers(0) {}
+
+    // Feed one raw reading; returns false if it was rejected
+    bool add(int16_t raw) {
+        if (raw < _min || raw > _max) {
+            miss();
+            return false;
+        }
+        if (_count > 0) {
+            int16_t step = raw - value();
+            if (step > _maxStep || step < -_maxStep) {
+                _outliers++;
+                if (++_rejects < REJECT_LIMIT) {
+                    miss();
+                    return false;
+                }
+                seed(raw); // persistent: a genuine change of level
+            }
+        } else {
+            seed(raw);
+        }
+        _rejects = 0;
+
+        _window[_head] = raw;
+        _head = (_head + 1) % WINDOW;
+        if (_count < WINDOW) _count++;
+        _ema += (((int32_t)median() << FRAC_BITS) - _ema) >> EMA_SHIFT;
+        good();
+        return true;
+    }
+
+    // A reading that never arrived (I2C failure)
+    void miss() {
+        _health -= (_health + (1 << HEALTH_SHIFT) - 1) >> HEALTH_SHIFT;
+    }
+
+    bool valid() const { return _count > 0; }
+
+    int16_t value() const {
+        return (int16_t)((_ema + (1 << (FRAC_BITS - 1))) >> FRAC_BITS);
+    }
+
+    uint8_t health() const { return _health; }
+    uint32_t outliers() const { return _outliers; }
+    void resetStats() { _outliers = 0; }
+};
+
+#endif // SENSOR_FILTER_H
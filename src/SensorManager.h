@@ -0,0 +1,278 @@
+#ifndef SENSOR_MANAGER_H
+#define SENSOR_MANAGER_H
+
+#include <Arduino.h>
+#include <Adafruit_Si7021.h>
+#include "I2cBus.h"
+#include "Profiler.h"
+
+// Owns the Si7021 sensors behind the TCA9548A, reached through I2cBus. Each mux channel is probed
+// (reset + ID check via begin()) once at startup; after that a poll only
+// issues the measurement. A channel is re-probed after a run of failed
+// reads, and absent channels are retried every few polls for hot-plugging.
+// Those re-probes run on the control task, so they never go through the
+// driver's begin() (a 50 ms delay and a heap allocation): a soft reset is
+// sent on one cycle and the user register's reset value checked on the
+// next, each a single short transaction.
+//
+// Sampling is pipelined: startCycle() fires a no-hold-master RH conversion
+// on every present channel back to back, and collectCycle() comes back
+// later for the results. The RH conversion also measures temperature, which
+// is read out with 0xE0 without a second conversion, so all four sensors
+// convert in parallel and each yields one RH/T pair per cycle.
+//
+// Each channel keeps a latency histogram of its collect (mux switch + RH
+// and T read-out) and a running count of I2C errors. The bus lock is held
+// for a whole start or collect pass, a few milliseconds at 400 kHz. Those
+// passes run on the control task, so they wait at most BUS_WAIT_MS for
+// the lock and skip the pass if the UI is mid-way through an OLED flush;
+// a skipped collect is simply retried, as the results stay in the sensors.
+class SensorManager {
+public:
+    static const uint8_t CHANNELS = 8; // TCA9548A ports; begin() picks the ones in use
+    static const uint8_t MAX_FAILURES = 3;   // consecutive bad reads before a re-probe
+    static const uint8_t REPROBE_POLLS = 20; // polls between probes of an absent channel
+    static const uint8_t CONVERSION_MS = 25; // 12-bit RH + 14-bit T, worst case
+    static const uint8_t BUS_WAIT_MS = 2;    // longest a start or collect waits for the bus
+
+    // Fixed point, straight from the raw codes: no floats on the control path
+    struct Sample {
+        int16_t temperature; // tenths of a degree F
+        int16_t humidity;    // tenths of a percent RH
+        unsigned long timestamp; // millis() when collected, 0 = never
+    };
+
+private:
+    static const uint8_t SI7021_ADDR = 0x40;
+    static const uint8_t CMD_MEASURE_RH_NOHOLD = 0xF5;
+    static const uint8_t CMD_READ_PREV_TEMP = 0xE0;
+    static const uint8_t CMD_RESET = 0xFE;
+    static const uint8_t CMD_READ_USER_REG = 0xE7;
+    static const uint8_t USER_REG_RESET = 0x3A; // user register after a reset
+
+    I2cBus &_bus;
+    Adafruit_Si7021 &_sensor;
+    TwoWire &_wire;
+    uint8_t _enabled; // bit per mux channel with a sensor wired to it
+    bool _present[CHANNELS];
+    bool _pending[CHANNELS];
+    uint8_t _failures[CHANNELS];
+    bool _resetSent[CHANNELS]; // re-probe under way, confirmed next cycle
+    uint32_t _errors[CHANNELS];
+    LatencyHistogram _readStats[CHANNELS];
+    Sample _samples[CHANNELS];
+    bool _cycleActive;
+    unsigned long _cycleStart;
+    uint32_t _busySkips;
+
+    // The helpers below expect the caller to hold the bus.
+
+    // Blocking probe through the driver, for begin() only
+    bool probe(uint8_t ch) {
+        return _bus.select(ch) && _sensor.begin();
+    }
+
+    // First half of a re-probe: mark the channel absent and soft-reset
+    // whatever answers on it. The part needs 15 ms, far less than a cycle.
+    void reprobe(uint8_t ch) {
+        _present[ch] = false;
+        _resetSent[ch] = _bus.select(ch) && sendCommand(CMD_RESET);
+    }
+
+    // Second half, a cycle later: a Si7021 fresh out of reset reads back
+    // its user register's default
+    bool confirmReprobe(uint8_t ch) {
+        _resetSent[ch] = false;
+        if (!_bus.select(ch) || !sendCommand(CMD_READ_USER_REG)) return false;
+        if (_wire.requestFrom(SI7021_ADDR, (uint8_t)1) != 1) return false;
+        return _wire.read() == USER_REG_RESET;
+    }
+
+    // Absent channels only get a re-probe every REPROBE_POLLS polls
+    bool ready(uint8_t ch) {
+        if (!(_enabled & (1 << ch))) return false;
+        if (_present[ch]) return true;
+        if (_resetSent[ch]) {
+            _present[ch] = confirmReprobe(ch);
+            return _present[ch];
+        }
+        if (++_failures[ch] < REPROBE_POLLS) return false;
+        _failures[ch] = 0;
+        reprobe(ch);
+        return false;
+    }
+
+    void recordFailure(uint8_t ch) {
+        _errors[ch]++;
+        _bus.failed();
+        if (++_failures[ch] >= MAX_FAILURES) {
+            _failures[ch] = 0;
+            reprobe(ch);
+        }
+    }
+
+    bool sendCommand(uint8_t cmd) {
+        _wire.beginTransmission(SI7021_ADDR);
+        _wire.write(cmd);
+        return _wire.endTransmission() == 0;
+    }
+
+    // Si7021 checksum: CRC-8, polynomial x^8 + x^5 + x^4 + 1, init 0x00
+    static uint8_t crc8(const uint8_t *data, uint8_t len) {
+        uint8_t crc = 0;
+        for (uint8_t i = 0; i < len; i++) {
+            crc ^= data[i];
+            for (uint8_t b = 0; b < 8; b++)
+                crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x31) : (uint8_t)(crc << 1);
+        }
+        return crc;
+    }
+
+    // degC = 175.72 * code / 65536 - 46.85, so degF = 316.296 * code / 65536 - 52.33
+    static int16_t tenthsF(uint16_t tCode) {
+        return (int16_t)((((int32_t)tCode * 3163) >> 16) - 523);
+    }
+
+    bool readResult(Sample &out) {
+        uint8_t rh[3];
+        if (_wire.requestFrom(SI7021_ADDR, (uint8_t)3) != 3) return false; // NACK = still converting
+        for (uint8_t i = 0; i < 3; i++) rh[i] = _wire.read();
+        if (crc8(rh, 2) != rh[2]) return false;
+
+        if (!sendCommand(CMD_READ_PREV_TEMP)) return false;
+        if (_wire.requestFrom(SI7021_ADDR, (uint8_t)2) != 2) return false;
+        uint16_t tCode = (uint16_t)_wire.read() << 8;
+        tCode |= _wire.read();
+        uint16_t rhCode = ((uint16_t)rh[0] << 8) | rh[1];
+
+        // Datasheet conversions, scaled to tenths:
+        //   %RH = 125 * code / 65536 - 6
+        //   degC: see tenthsF()
+        int32_t humidity = (((int32_t)rhCode * 1250) >> 16) - 60;
+        out.humidity = (int16_t)constrain(humidity, (int32_t)0, (int32_t)1000);
+        out.temperature = tenthsF(tCode);
+        out.timestamp = millis();
+        return true;
+    }
+
+public:
+    SensorManager(I2cBus &bus, Adafruit_Si7021 &sensor)
+        : _bus(bus), _sensor(sensor), _wire(bus.wire()), _enabled(0),
+          _cycleActive(false), _cycleStart(0), _busySkips(0) {
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            _present[ch] = false;
+            _pending[ch] = false;
+            _failures[ch] = 0;
+            _resetSent[ch] = false;
+            _errors[ch] = 0;
+            _samples[ch].temperature = 0;
+            _samples[ch].humidity = 0;
+            _samples[ch].timestamp = 0;
+        }
+    }
+
+    // Call once from setup(), after bus.begin(), with a bit set for every
+    // mux channel that has a sensor wired to it
+    void begin(uint8_t channelMask) {
+        I2cBus::Guard guard(_bus);
+        _enabled = channelMask;
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            _present[ch] = enabled(ch) && probe(ch);
+            _failures[ch] = 0;
+        }
+    }
+
+    bool enabled(uint8_t ch) const {
+        return ch < CHANNELS && (_enabled & (1 << ch));
+    }
+
+    bool present(uint8_t ch) const {
+        return ch < CHANNELS && _present[ch];
+    }
+
+    // Kick off a conversion on every present channel and return immediately.
+    // Does nothing while the previous cycle is still waiting to be collected,
+    // or if the bus stays busy; returns whether a cycle was started.
+    bool startCycle() {
+        if (_cycleActive) return false;
+        I2cBus::Guard guard(_bus, BUS_WAIT_MS);
+        if (!guard.held()) {
+            _busySkips++;
+            return false;
+        }
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            _pending[ch] = false;
+            if (!ready(ch)) continue;
+            _pending[ch] = _bus.select(ch) && sendCommand(CMD_MEASURE_RH_NOHOLD);
+            if (!_pending[ch]) recordFailure(ch);
+        }
+        _cycleStart = millis();
+        _cycleActive = true;
+        return true;
+    }
+
+    // Collect the conversions started by startCycle(). Returns false without
+    // touching the bus if they cannot have finished yet or the bus is busy.
+    bool collectCycle() {
+        if (!_cycleActive || millis() - _cycleStart < CONVERSION_MS) return false;
+
+        I2cBus::Guard guard(_bus, BUS_WAIT_MS);
+        if (!guard.held()) {
+            _busySkips++;
+            return false;
+        }
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            if (!_pending[ch]) continue;
+            int64_t start = esp_timer_get_time();
+            bool ok = _bus.select(ch) && readResult(_samples[ch]);
+            _readStats[ch].recordSince(start);
+            if (ok) _failures[ch] = 0;
+            else recordFailure(ch);
+            _pending[ch] = false;
+        }
+        _cycleActive = false;
+        return true;
+    }
+
+    // One-off read of the temperature kept from a channel's last
+    // conversion (used by the "bench" command). Refused while a cycle is
+    // waiting to be collected, as it would move the sensor's read pointer
+    // off the pending RH result.
+    bool readTemperature(uint8_t ch, int16_t &temperature) {
+        if (!present(ch)) return false;
+        I2cBus::Guard guard(_bus);
+        if (_cycleActive || !_bus.select(ch) || !sendCommand(CMD_READ_PREV_TEMP)) return false;
+        if (_wire.requestFrom(SI7021_ADDR, (uint8_t)2) != 2) return false;
+        uint16_t tCode = (uint16_t)_wire.read() << 8;
+        tCode |= _wire.read();
+        temperature = tenthsF(tCode);
+        return true;
+    }
+
+    const LatencyHistogram &readLatency(uint8_t ch) const {
+        return _readStats[ch < CHANNELS ? ch : 0];
+    }
+
+    // Failed probes, commands and read-outs since boot or resetStats()
+    uint32_t errors(uint8_t ch) const {
+        return ch < CHANNELS ? _errors[ch] : 0;
+    }
+
+    // Start or collect passes skipped because the bus stayed busy
+    uint32_t busySkips() const { return _busySkips; }
+
+    void resetStats() {
+        for (uint8_t ch = 0; ch < CHANNELS; ch++) {
+            _readStats[ch].reset();
+            _errors[ch] = 0;
+        }
+        _busySkips = 0;
+    }
+
+    // Most recent good RH/T pair for a channel; keeps old values on failure
+    const Sample &sample(uint8_t ch) const {
+        return _samples[ch < CHANNELS ? ch : 0];
+    }
+};
+
+#endif // SENSOR_MANAGER_H
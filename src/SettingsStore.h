@@ -0,0 +1,69 @@
+#ifndef SETTINGS_STORE_H
+#define SETTINGS_STORE_H
+
+#include <Arduino.h>
+#include "RecordRing.h"
+
+// Persists a plain settings struct T in EEPROM with coalesced writes.
+//
+// The struct the firmware uses is the RAM shadow; callers change it freely
+// and call markDirty(). service() commits once the settings have been quiet
+// for a while, and flush() commits right away (e.g. when leaving a screen).
+// A commit whose contents match the last one written is skipped; T
+// supplies operator== for that, since a memcmp would also compare its
+// padding bytes. Records go through a RecordRing, so a corrupted one
+// falls back to the previous.
+template <typename T>
+class SettingsStore {
+public:
+    static const uint8_t SLOTS = 2;
+    static const uint16_t MAGIC = 0x5453; // "TS"
+
+private:
+    typedef RecordRing<T, SLOTS, MAGIC> Ring;
+
+    T &_live;
+    T _committed;
+    Ring _ring;
+    bool _dirty;
+    unsigned long _lastChange;
+
+public:
+    static const int STORAGE_BYTES = Ring::STORAGE_BYTES;
+
+    SettingsStore(T &live, int baseAddress, uint8_t version)
+        : _live(live), _committed(live), _ring(baseAddress, version), _dirty(false), _lastChange(0) {}
+
+    // Call after EEPROM.begin(). Loads the newest valid record into the live
+    // struct and returns true, or leaves the defaults in place and returns
+    // false if no slot holds a valid record for this version.
+    bool begin() {
+        bool found = _ring.load(_live);
+        _committed = _live;
+        _dirty = false;
+        return found;
+    }
+
+    void markDirty() {
+        _dirty = true;
+        _lastChange = millis();
+    }
+
+    bool dirty() const { return _dirty; }
+    uint32_t commits() const { return _ring.commits(); }
+
+    // Commit once nothing has changed for quietMs
+    void service(unsigned long quietMs) {
+        if (_dirty && millis() - _lastChange >= quietMs) flush();
+    }
+
+    void flush() {
+        if (!_dirty) return;
+        _dirty = false;
+        if (_committed == _live) return;
+        _ring.write(_live);
+        _committed = _live;
+    }
+};
+
+#endif // SETTINGS_STORE_H
@@ -0,0 +1,103 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <Arduino.h>
+
+// State handed between the control task (core 1) and the UI task (core 0).
+// The control task is the only writer of ControlSnapshot; the UI only ever
+// talks back through ControlCommand messages on a queue.
+
+// Heated enclosures and passive filament boxes. Override with build flags
+// (e.g. -DZONE_COUNT=4) together with the wiring tables in main.cpp.
+#ifndef ZONE_COUNT
+#define ZONE_COUNT 2
+#endif
+#ifndef FILAMENT_BOX_COUNT
+#define FILAMENT_BOX_COUNT 2
+#endif
+
+struct PidGains {
+    float kp;
+    float ki;
+    float kd;
+
+    bool operator==(const PidGains &o) const {
+        return kp == o.kp && ki == o.ki && kd == o.kd;
+    }
+};
+
+// Temperatures are tenths of a degree F and humidities tenths of a percent,
+// as produced by SensorManager; the UI converts only when it prints them.
+struct ZoneStatus {
+    int16_t temp;
+    int16_t humidity;
+    int16_t setpoint; // as last applied by the control task
+    uint8_t duty;   // LEDC heater duty as granted by the power budget, 0-255
+    uint8_t demand; // PID output before the budget
+    bool heaterOn;
+    PidGains gains;       // gains the PID is running with
+    uint8_t tuneState;    // RelayAutoTune::State
+    uint8_t tuneProgress; // percent
+    uint8_t fault;        // RunawayDetector::Fault, latched
+    uint8_t sensorHealth; // SensorFilter::health(), 0-100
+};
+
+struct ControlSnapshot {
+    ZoneStatus zone[ZONE_COUNT];
+    int16_t filamentTemp[FILAMENT_BOX_COUNT];
+    int16_t filamentHumidity[FILAMENT_BOX_COUNT];
+    uint8_t filamentHealth[FILAMENT_BOX_COUNT];
+    bool overheat;
+    unsigned long sampleMillis;
+};
+
+enum ControlCommandType : uint8_t {
+    CMD_SET_SETPOINT, // value in tenths of a degree F
+    CMD_HEATER_ON,    // (re)start heating; also clears a latched runaway fault
+    CMD_HEATER_OFF,
+    CMD_ALL_OFF,
+    CMD_SET_POWER_BUDGET, // value in duty counts across all heaters; zone ignored
+    CMD_AUTOTUNE // relay-tune `zone` around its current setpoint, heater on
+};
+
+struct ControlCommand {
+    ControlCommandType type;
+    uint8_t zone;
+    int32_t value;
+};
+
+// Single-writer sequence lock. The writer bumps the sequence to an odd value,
+// copies the data, then makes it even again; readers retry until they see
+// the same even sequence on both sides of their copy. Neither side blocks.
+template <typename T>
+class SeqLockSnapshot {
+private:
+    volatile uint32_t _seq;
+    T _data;
+
+public:
+    SeqLockSnapshot() : _seq(0), _data() {}
+
+    void publish(const T &value) {
+        _seq = _seq + 1;
+        __sync_synchronize();
+        _data = value;
+        __sync_synchronize();
+        _seq = _seq + 1;
+    }
+
+    T read() const {
+        T copy;
+        uint32_t before, after;
+        do {
+            before = _seq;
+            __sync_synchronize();
+            copy = _data;
+            __sync_synchronize();
+            after = _seq;
+        } while ((before & 1) || before != after);
+        return copy;
+    }
+};
+
+#endif // SHARED_STATE_H
@@ -0,0 +1,131 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "Crc16.h"
+#include "SharedState.h"
+
+// COBS-encode `len` bytes from `in` into `out`, which must hold at least
+// len + len / 254 + 1 bytes. The result contains no zero bytes, so a 0x00
+// can delimit frames. Returns the encoded length.
+inline size_t cobsEncode(const uint8_t *in, size_t len, uint8_t *out) {
+    size_t code = 0; // index of the pending code byte
+    size_t o = 1;
+    uint8_t run = 1;
+    for (size_t i = 0; i < len; i++) {
+        if (in[i] == 0) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+            continue;
+        }
+        out[o++] = in[i];
+        if (++run == 0xFF) {
+            out[code] = run;
+            code = o++;
+            run = 1;
+        }
+    }
+    out[code] = run;
+    return o;
+}
+
+// Status record sent by the console telemetry and shared with the network
+// task. Little-endian and packed; a host decoder mirrors this layout.
+struct __attribute__((packed)) TelemetryZone {
+    int16_t temp;     // tenths of a degree F
+    int16_t humidity; // tenths of a percent
+    int16_t setpoint; // tenths of a degree F
+    uint8_t duty;     // as applied to the heater, 0-255
+    uint8_t demand;   // PID output before the power budget
+    uint8_t health;   // sensor health, 0-100
+    uint8_t flags;    // TelemetryRecord::FLAG_*
+    uint32_t timerRemaining; // seconds, 0 unless running on a timer
+};
+
+struct __attribute__((packed)) TelemetryBox {
+    int16_t temp;
+    int16_t humidity;
+    uint8_t health;
+    uint8_t flags; // TelemetryRecord::FLAG_HUMIDITY
+};
+
+struct __attribute__((packed)) TelemetryRecord {
+    enum : uint8_t { STATUS = 1 };
+    enum : uint8_t {
+        FLAG_HEATER = 0x01,
+        FLAG_TIMER = 0x02,
+        FLAG_HUMIDITY = 0x04,
+        FLAG_TUNING = 0x08,
+        FLAG_FAULT = 0x10,
+        FLAG_OVERHEAT = 0x01 // record-level flags
+    };
+
+    uint8_t type; // STATUS
+    uint8_t zoneCount;
+    uint8_t boxCount;
+    uint8_t flags; // FLAG_OVERHEAT
+    uint32_t sequence;
+    uint32_t millis;
+    TelemetryZone zone[ZONE_COUNT];
+    TelemetryBox box[FILAMENT_BOX_COUNT];
+};
+
+// Writes framed binary records to a serial port without ever blocking:
+//
+//   0x00, COBS(payload + CRC-16/CCITT-FALSE little-endian), 0x00
+//
+// The leading delimiter resynchronises a receiver after any text that was
+// printed to the same port. A frame is only written if the UART driver's
+// TX buffer (drained by the UART interrupt) has room for all of it;
+// otherwise it is dropped and counted, so a slow or absent host costs
+// nothing.
+class TelemetryWriter {
+public:
+    static const size_t MAX_PAYLOAD = 192;
+
+private:
+    static const size_t MAX_FRAME = MAX_PAYLOAD + 2 + (MAX_PAYLOAD + 2) / 254 + 1 + 2;
+
+    HardwareSerial &_port;
+    uint8_t _raw[MAX_PAYLOAD + 2];
+    uint8_t _frame[MAX_FRAME];
+    uint32_t _sent;
+    uint32_t _dropped;
+
+public:
+    TelemetryWriter(HardwareSerial &port) : _port(port), _sent(0), _dropped(0) {}
+
+    bool send(const void *payload, size_t len) {
+        if (len > MAX_PAYLOAD) return false;
+        memcpy(_raw, payload, len);
+        uint16_t crc = crc16(payload, len);
+        _raw[len] = crc & 0xFF;
+        _raw[len + 1] = crc >> 8;
+
+        size_t n = 0;
+        _frame[n++] = 0;
+        n += cobsEncode(_raw, len + 2, _frame + n);
+        _frame[n++] = 0;
+
+        if ((size_t)_port.availableForWrite() < n) {
+            _dropped++;
+            return false;
+        }
+        _port.write(_frame, n);
+        _sent++;
+        return true;
+    }
+
+    uint32_t sent() const { return _sent; }
+    uint32_t dropped() const { return _dropped; }
+
+    void resetStats() {
+        _sent = 0;
+        _dropped = 0;
+    }
+};
+
+static_assert(sizeof(TelemetryRecord) <= TelemetryWriter::MAX_PAYLOAD, "TelemetryRecord too large");
+
+#endif // TELEMETRY_H
@@ -0,0 +1,73 @@
+#ifndef TREND_HISTORY_H
+#define TREND_HISTORY_H
+
+#include <Arduino.h>
+
+// Fixed-size history of one sensor channel, downsampled into buckets
+// (e.g. one per minute). Samples are folded into an open bucket by add();
+// close() seals it into the ring, overwriting the oldest bucket once full.
+// Values stay in the caller's int16 fixed point (tenths of a degree F /
+// tenths of a percent), so a bucket is 8 bytes and the whole ring is a
+// static BUCKETS * 8 bytes with no heap use.
+template <uint16_t BUCKETS>
+class TrendHistory {
+public:
+    struct Bucket {
+        int16_t minTemp;
+        int16_t maxTemp;
+        int16_t avgTemp;
+        int16_t avgHumidity;
+    };
+
+private:
+    Bucket _ring[BUCKETS];
+    uint16_t _head; // next slot to write
+    uint16_t _count;
+
+    int32_t _sumTemp;
+    int32_t _sumHumidity;
+    int16_t _minTemp;
+    int16_t _maxTemp;
+    uint16_t _samples;
+
+public:
+    TrendHistory() : _head(0), _count(0), _sumTemp(0), _sumHumidity(0),
+                     _minTemp(INT16_MAX), _maxTemp(INT16_MIN), _samples(0) {}
+
+    void add(int16_t temp, int16_t humidity) {
+        _sumTemp += temp;
+        _sumHumidity += humidity;
+        if (temp < _minTemp) _minTemp = temp;
+        if (temp > _maxTemp) _maxTemp = temp;
+        _samples++;
+    }
+
+    // Seal the open bucket. A bucket period without samples leaves no gap
+    // marker; the history simply skips it.
+    void close() {
+        if (_samples == 0) return;
+        Bucket &b = _ring[_head];
+        b.minTemp = _minTemp;
+        b.maxTemp = _maxTemp;
+        b.avgTemp = (int16_t)(_sumTemp / _samples);
+        b.avgHumidity = (int16_t)(_sumHumidity / _samples);
+        _head = (_head + 1) % BUCKETS;
+        if (_count < BUCKETS) _count++;
+
+        _sumTemp = 0;
+        _sumHumidity = 0;
+        _minTemp = INT16_MAX;
+        _maxTemp = INT16_MIN;
+        _samples = 0;
+    }
+
+    uint16_t size() const { return _count; }
+    static uint16_t capacity() { return BUCKETS; }
+
+    // Bucket by age: 0 is the oldest kept, size() - 1 the newest
+    const Bucket &at(uint16_t index) const {
+        return _ring[(_head + BUCKETS - _count + index) % BUCKETS];
+    }
+};
+
+#endif // TREND_HISTORY_H
@@ -0,0 +1,85 @@
+#ifndef UI_FORMAT_H
+#define UI_FORMAT_H
+
+#include <Arduino.h>
+
+// Number formatting for the display without floats or printf. Values come
+// in the firmware's fixed-point units (tenths of a degree or percent, whole
+// seconds) and are written into caller-provided buffers. Each append*()
+// writes at `p` and returns the new end; the caller terminates the string.
+
+inline char *appendText(char *p, const char *s) {
+    while (*s) *p++ = *s++;
+    return p;
+}
+
+inline char *appendUInt(char *p, uint32_t v) {
+    char digits[10];
+    uint8_t n = 0;
+    do {
+        digits[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v);
+    while (n) *p++ = digits[--n];
+    return p;
+}
+
+// `v` scaled by 10^decimals, e.g. (-5, 1) -> "-0.5"
+inline char *appendFixed(char *p, int32_t v, uint8_t decimals) {
+    uint32_t mag = (v < 0) ? -(uint32_t)v : (uint32_t)v;
+    if (v < 0) *p++ = '-';
+    uint32_t scale = 1;
+    for (uint8_t i = 0; i < decimals; i++) scale *= 10;
+    p = appendUInt(p, mag / scale);
+    if (decimals) {
+        *p++ = '.';
+        uint32_t frac = mag % scale;
+        for (scale /= 10; scale; scale /= 10) {
+            *p++ = '0' + frac / scale;
+            frac %= scale;
+        }
+    }
+    return p;
+}
+
+inline char *appendTenths(char *p, int32_t v) { return appendFixed(p, v, 1); }
+
+// Seconds as "Hh Mm"
+inline char *appendDuration(char *p, uint32_t seconds) {
+    uint32_t minutes = seconds / 60;
+    p = appendUInt(p, minutes / 60);
+    p = appendText(p, "h ");
+    p = appendUInt(p, minutes % 60);
+    *p++ = 'm';
+    return p;
+}
+
+// One line of text on the display, rebuilt only when the value behind it
+// changes; an unchanged frame costs a compare. A cache must always be used
+// with the same formatter, or invalidate()d when that changes.
+class TextCache {
+public:
+    static const uint8_t SIZE = 28;
+    typedef char *(*Format)(char *out, int32_t value); // returns end of text
+
+private:
+    char _text[SIZE];
+    int32_t _value;
+    bool _valid;
+
+public:
+    TextCache() : _value(0), _valid(false) { _text[0] = '\0'; }
+
+    const char *get(int32_t value, Format format) {
+        if (!_valid || value != _value) {
+            *format(_text, value) = '\0';
+            _value = value;
+            _valid = true;
+        }
+        return _text;
+    }
+
+    void invalidate() { _valid = false; }
+};
+
+#endif // UI_FORMAT_H
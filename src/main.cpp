@@ -4,16 +4,21 @@
   ✅ Included Features:
   - PID control for 2 independent heaters (Enclosure 1 & 2)
   - PWM output via LEDC (ESP32-native)
-  - EEPROM-ready structure
-  - OLED display with idle-time rotation (Filament + Enclosures)
+  - Heater power budget with phase-interleaved PWM (no overlapping on-times)
+  - EEPROM settings with coalesced, CRC-checked writes
+  - Run-state journal: setpoints, heaters and timers resume after a reset
+  - OLED display with idle-time rotation (Filament + Enclosures) and power-save
   - Per-zone timers with on-screen countdown
+  - 48 h temperature/humidity history with on-screen trend graphs
   - Manual or timer mode selection per enclosure
   - Overheat failsafe (130°F cutoff) + Buzzer alert loop
+  - Per-zone runaway detection: lost sensor, implausible rise, not heating
   - Buzzer alerts:
       • 5 minutes left → single beep
       • 30 sec countdown → 4 beeps + final long beep
       • Continuous beeping on thermal runaway (130°F+)
   - Optional AUTO SHUT-OFF after 56 hours of runtime (toggleable)
+  - Optional Wi-Fi/MQTT status and remote control (esp32dev_net build)
 
   🔹 MAIN MENU:
   - 3D Enclosure 1
@@ -21,6 +26,7 @@
   - Filament Box 1
   - Filament Box 2
   - All Sensors Display
+  - Temp / Humidity Trends
   - SHUT ALL OFF
   - Settings (including auto-off toggle and PID Auto-Tune)
 
@@ -43,6 +49,7 @@
       - CH0 = Filament Sensor (Si7021)
       - CH1 = Enclosure 1 Sensor
       - CH2 = Enclosure 2 Sensor
+      - CH3 = Filament Box 2 Sensor
   - Rotary Encoder:        CLK: GPIO32, DT: GPIO33, SW: GPIO25
   - Back Button:           GPIO26
 
@@ -51,21 +58,57 @@
 */
 
 #include <Arduino.h>
+#include <array>
 #include "driver/ledc.h"
 #include <Wire.h>
-#include <TCA9548A.h>
 #include <Adafruit_Si7021.h>
-#include <PID_v1.h>
-#include <FastPID.h>
 #include <EEPROM.h>
 #include <U8g2lib.h>
 #include "ESP32Encoder.h" // Use our custom ESP32 encoder implementation
+#include "InputEvents.h"
+#include "Scheduler.h"
+#include "I2cBus.h"
+#include "SharedState.h"
+#include "SensorManager.h"
+#include "SensorFilter.h"
+#include "FrameDiff.h"
+#include "UiFormat.h"
+#include "Menu.h"
+#include "SettingsStore.h"
+#include "RunJournal.h"
+#include "Profiler.h"
+#include "Buzzer.h"
+#include "RelayAutoTune.h"
+#include "HeaterController.h"
+#include "RunawayDetector.h"
+#include "PowerScheduler.h"
+#include "TrendHistory.h"
+#include "Telemetry.h"
+#include "EventQueue.h"
+
+// Wi-Fi/MQTT task, see the esp32dev_net environment in platformio.ini
+#ifndef ENABLE_NETWORK
+#define ENABLE_NETWORK 0
+#endif
+#if ENABLE_NETWORK
+#include "MqttLink.h"
+#endif
 
 #define HEATER1_PIN 12
 #define HEATER2_PIN 13
 #define BUZZER_PIN 27
 #define OLED_RESET 16
-#define EEPROM_SIZE 128
+#define I2C_SDA 21
+#define I2C_SCL 22
+#define EEPROM_SIZE 1024
+#define SETTINGS_EEPROM_ADDR 0
+#define SETTINGS_VERSION 3
+#define SETTINGS_QUIET_MS 5000 // commit once settings stop changing for this long
+#define JOURNAL_EEPROM_ADDR 512
+#define JOURNAL_VERSION 1
+#define JOURNAL_SLOTS 2
+#define JOURNAL_BATCH_MS 2000 // run-state changes this close together share a commit
+#define JOURNAL_CHECKPOINT_MS 300000 // how often a running zone's progress is journalled
 #define ENCODER_CLK 32
 #define ENCODER_DT 33
 #define ENCODER_SW 25
@@ -74,795 +117,2177 @@
 #define PWM_RES 8
 #define HEATER1_CH 0
 #define HEATER2_CH 1
-#define SCREEN_IDLE_TIMEOUT 300000
+#define SCREEN_IDLE_TIMEOUT 300000    // no input: rotate status views
+#define SCREEN_SLEEP_TIMEOUT 1800000  // no input: OLED power-save
 #define SCREEN_SWITCH_INTERVAL 5000
+#define ACTIVE_FRAME_MS 50 // frame rate caps, see updateScreen()
+#define IDLE_FRAME_MS 1000
+#define MENU_VISIBLE_ROWS 4
 #define MAX_MANUAL_RUNTIME_SECONDS 201600
 
-TCA9548A tca;
+// FreeRTOS task layout: control on core 1 at high priority, UI on core 0
+#define CONTROL_CORE 1
+#define CONTROL_PRIORITY 5
+#define CONTROL_STACK 4096
+#define UI_CORE 0
+#define UI_PRIORITY 1
+#define UI_STACK 8192
+#define CONTROL_QUEUE_LEN 8
+#define NET_CORE 0
+#define NET_PRIORITY 1
+#define NET_STACK 6144
+#define TIMER_QUEUE_LEN 4
+
+// Fixed control rate; FastPID's gains are defined per second at this rate
+#define CONTROL_HZ 10
+#define CONTROL_PERIOD_MS (1000 / CONTROL_HZ)
+#define SAMPLE_INTERVAL_MS 500 // sensor cycles start at this rate, independent of CONTROL_HZ
+static_assert(1000 % CONTROL_HZ == 0, "CONTROL_HZ must divide 1000");
+#define OVERHEAT_LIMIT 1300 // tenths of a degree F
+// Combined heater duty allowed at any instant, in LEDC counts: 256 is one
+// heater fully on, 256 * ZONE_COUNT lifts the cap. "power <counts>" on the
+// console changes it until the next reset.
+#ifndef HEATER_POWER_BUDGET
+#define HEATER_POWER_BUDGET 256
+#endif
+
+// UI scheduler task periods (ms)
+#define SNAPSHOT_INTERVAL_MS 50
+#define INPUT_INTERVAL_MS 5 // drains the input queue; the buttons and encoder post from interrupts
+#define INPUT_QUEUE_LEN 16
+#define DISPLAY_INTERVAL_MS 20 // display controller tick; frames are rate-capped separately
+#define TIMER_INTERVAL_MS 100 // only peeks at the earliest timer event
+#define HUMIDITY_INTERVAL_MS 1000
+#define SETTINGS_INTERVAL_MS 500
+#define JOURNAL_INTERVAL_MS 1000
+#define SERIAL_INTERVAL_MS 50
+#define SERIAL_LINE_MAX 32
+#define SERIAL_TX_BUFFER 1024 // UART driver ring buffer; telemetry never waits on the wire
+#define TELEMETRY_TICK_MS 50
+#define TELEMETRY_DEFAULT_MS 1000
+#define NET_STATUS_INTERVAL_MS 250 // UI -> network task status copy
+#define NET_POLL_MS 50
+#define NET_PUBLISH_DEFAULT_MS 10000
+#define NET_PUBLISH_MIN_MS 1000
+#define HISTORY_SAMPLE_MS 1000
+#define HISTORY_HOURS 48
+// The trend screen draws 100 columns, so buckets finer than that buy
+// nothing; builds short of RAM (the network one) can lower this further
+#ifndef HISTORY_BUCKETS
+#define HISTORY_BUCKETS 576 // 5-minute buckets, 4.5 KB per channel
+#endif
+#define HISTORY_BUCKET_MS (HISTORY_HOURS * 3600000UL / HISTORY_BUCKETS)
+
+I2cBus i2c(Wire, I2C_SDA, I2C_SCL); // sensors and OLED share it across tasks
 Adafruit_Si7021 sensor = Adafruit_Si7021();
+SensorManager sensors(i2c, sensor);
+
+// Per mux channel, between SensorManager and the control loop (control task)
+struct ChannelFilter
+{
+  SensorFilter temp;
+  SensorFilter humidity;
+  unsigned long rawMillis;      // timestamp of the last reading seen
+  unsigned long acceptedMillis; // of the last temperature the filter took, 0 = none
+
+  ChannelFilter()
+      : temp(-400, 2570, 50), // Si7021 range -40..125 C; 5 F per sample is not physical
+        humidity(0, 1000, 150),
+        rawMillis(0), acceptedMillis(0)
+  {
+  }
+};
+
+ChannelFilter filters[SensorManager::CHANNELS];
 U8G2_SSD1309_128X64_NONAME2_F_HW_I2C u8g2(U8G2_R0, OLED_RESET);
+FrameDiff oled(u8g2, i2c); // use oled.flush() instead of u8g2.sendBuffer()
 ESP32Encoder encoder(ENCODER_CLK, ENCODER_DT);
+ESP32Encoder benchEncoder(ENCODER_CLK, ENCODER_DT); // never attached; "bench" times its polled tick()
+Scheduler scheduler;
+
+// Written only by the control task, read by the UI through `view`
+SeqLockSnapshot<ControlSnapshot> controlState;
+PowerScheduler<ZONE_COUNT> power(HEATER_POWER_BUDGET); // control task
+ControlSnapshot view = {};
+QueueHandle_t controlQueue = nullptr;
+
+// Stage timings; dump with "stats" on the serial console
+LatencyHistogram pidStats;    // control task
+LatencyHistogram jitterStats; // control task, |period - CONTROL_PERIOD_MS|
+uint32_t controlOverruns = 0; // periods that ran past their deadline
+LatencyHistogram eepromStats; // UI task, settings and run journal commits
+char serialLine[SERIAL_LINE_MAX];
+uint8_t serialLineLen = 0;
+
+// Telemetry stream on the console port, see sendTelemetry()
+enum TelemetryMode : uint8_t
+{
+  TELEMETRY_OFF,
+  TELEMETRY_BINARY,
+  TELEMETRY_TEXT
+};
+
+
+TelemetryWriter telemetry(Serial);
+TelemetryMode telemetryMode = TELEMETRY_OFF;
+unsigned long telemetryIntervalMs = TELEMETRY_DEFAULT_MS;
+uint32_t telemetrySequence = 0;
+uint32_t telemetryTextDropped = 0;
+
+#if ENABLE_NETWORK
+#ifndef WIFI_SSID
+#define WIFI_SSID ""
+#endif
+#ifndef WIFI_PASSWORD
+#define WIFI_PASSWORD ""
+#endif
+#ifndef MQTT_HOST
+#define MQTT_HOST "mqtt.local"
+#endif
+#ifndef MQTT_PORT
+#define MQTT_PORT 1883
+#endif
+#ifndef MQTT_BASE_TOPIC
+#define MQTT_BASE_TOPIC "enclosure"
+#endif
+
+// Remote timer start for a zone; seconds == 0 switches it to manual mode.
+// Timers live on the UI side, so these go to the UI task rather than to
+// controlQueue.
+struct TimerCommand
+{
+  uint8_t zone;
+  uint32_t seconds;
+};
+
+MqttLink mqtt;
+SeqLockSnapshot<TelemetryRecord> netStatus; // written by the UI task only
+QueueHandle_t timerQueue = nullptr;
+volatile unsigned long netPublishMs = NET_PUBLISH_DEFAULT_MS;
+#endif
+
+long cursorPos = 0; // menu row or editor index, moved by input events
+InputQueue inputQueue; // encoder and buttons -> UI task
+EncoderAcceleration encoderAccel; // encoder ISR only
+ButtonInput selectInput(ENCODER_SW, inputQueue, INPUT_CLICK, INPUT_LONG_PRESS);
+ButtonInput backInput(BACK_BUTTON, inputQueue, INPUT_BACK);
+uint8_t screenIndex = SCREEN_MAIN; // Start in main menu
+
+
+// Humidity alarm slots: the zones first, then the filament boxes
+#define HUMIDITY_SLOTS (ZONE_COUNT + FILAMENT_BOX_COUNT)
+
+const PidGains DEFAULT_GAINS = {2.0, 5.0, 1.0};
+
+// Persisted user settings. This live copy is also SettingsStore's RAM
+// shadow: change a field, then call settingsStore.markDirty().
+struct Settings
+{
+  int16_t humidityLimit[HUMIDITY_SLOTS];
+  bool humidityAlarm[HUMIDITY_SLOTS];
+  bool autoShutoffEnabled;
+  bool beepOnPush;
+  PidGains gains[ZONE_COUNT]; // per degree F, from the auto-tuner
+
+  // Field by field: the struct has padding, which a memcmp would compare
+  bool operator==(const Settings &o) const
+  {
+    for (uint8_t i = 0; i < HUMIDITY_SLOTS; i++)
+    {
+      if (humidityLimit[i] != o.humidityLimit[i] || humidityAlarm[i] != o.humidityAlarm[i])
+        return false;
+    }
+    for (uint8_t i = 0; i < ZONE_COUNT; i++)
+    {
+      if (!(gains[i] == o.gains[i]))
+        return false;
+    }
+    return autoShutoffEnabled == o.autoShutoffEnabled && beepOnPush == o.beepOnPush;
+  }
+};
+
+Settings defaultSettings()
+{
+  Settings s = {};
+  for (uint8_t i = 0; i < HUMIDITY_SLOTS; i++)
+    s.humidityLimit[i] = 65;
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+    s.gains[i] = DEFAULT_GAINS;
+  s.autoShutoffEnabled = true;
+  s.beepOnPush = true;
+  return s;
+}
 
-long lastEncoderPos = 0;
-bool encoderButtonPressed = false;
-bool backButtonPressed = false;
-bool autoShutoffEnabled = true;
-bool beepOnPush = true;
-int screenIndex = 100; // Start in main menu
-int mainMenuIndex = 0;
-int settingsMenuIndex = 0;
-
-float filamentTemp = 0;
-float filamentTemp2 = 0;
-int humidityLimitF1 = 65;
-bool humidityAlarmF1 = false;
-int humidityLimitF2 = 65;
-bool humidityAlarmF2 = false;
+Settings settings = defaultSettings();
+SettingsStore<Settings> settingsStore(settings, SETTINGS_EEPROM_ADDR, SETTINGS_VERSION);
+static_assert(SETTINGS_EEPROM_ADDR + SettingsStore<Settings>::STORAGE_BYTES <= JOURNAL_EEPROM_ADDR, "settings overlap the run journal");
 
+// One heated enclosure: its wiring and limits, the UI-side settings, and
+// the control task's working state.
 struct Zone
 {
-  String name;
-  float currentTemp;
-  float targetTemp;
+  const char *name;
+  const char *label;     // short name for compact screens
+  uint8_t muxChannel;    // TCA9548A port of the zone's Si7021
+  uint8_t heaterPin;
+  uint8_t ledcChannel;
+  int16_t overheatLimit; // tenths of a degree F
+
+  // UI task
+  int targetTemp; // degrees F
   unsigned long timerSeconds;
   unsigned long timerStart;
-  bool heaterOn;
-  bool useTimer;
-  unsigned long manualStart;
-  int heaterPin;
-  double input, output, setpoint;
-  PID *pid;
+  bool useTimer;         // a confirmed timer is running; set only by armZoneTimer()
+  bool pendingTimerMode; // timer mode picked, duration not yet confirmed
+  unsigned long manualStart; // millis() when manual heating began
+
+  // Control task
+  bool heaterOn;       // enabled by CMD_HEATER_ON, off after a stop or a cutoff
+  int16_t currentTemp; // tenths of a degree F
+  int16_t humidity;    // tenths of a percent
+  unsigned long sampleMillis; // when currentTemp was measured, 0 = never
+  int16_t setpoint;    // tenths of a degree F, control copy of targetTemp
+  uint8_t duty;        // granted by the power scheduler
+  uint8_t demand;      // PID output
+  HeaterController controller; // configured from settings.gains in setup()
+  RunawayDetector runaway;
+};
+
+Zone makeZone(const char *name, const char *label, uint8_t muxChannel, uint8_t heaterPin, uint8_t ledcChannel)
+{
+  return {name, label, muxChannel, heaterPin, ledcChannel, OVERHEAT_LIMIT,
+          90, 0, 0, false, false, 0,
+          true, 0, 0, 0, 900, 0, 0, HeaterController(CONTROL_HZ), RunawayDetector()};
+}
+
+// Unheated filament box, monitored only
+struct FilamentBox
+{
+  const char *name;
+  const char *label;
+  uint8_t muxChannel;
+  int16_t temp;     // tenths of a degree F, control task
+  int16_t humidity; // tenths of a percent, control task
 };
 
-Zone enclosure1 = {"3D Enclosure 1", 0, 90.0, 0, 0, false, true, 0, HEATER1_PIN, 0, 0, 90.0, nullptr};
-int humidityLimit1 = 65;
-bool humidityAlarm1 = false;
-Zone enclosure2 = {"3D Enclosure 2", 0, 90.0, 0, 0, false, true, 0, HEATER2_PIN, 0, 0, 90.0, nullptr};
-int humidityLimit2 = 65;
-bool humidityAlarm2 = false;
+// Wiring tables. Add a row (and raise ZONE_COUNT / FILAMENT_BOX_COUNT) to
+// add an enclosure or box, plus its entries in MAIN_ITEMS and SETTINGS_ITEMS.
+std::array<Zone, ZONE_COUNT> zones = {{
+    makeZone("3D Enclosure 1", "ENC 1", 1, HEATER1_PIN, HEATER1_CH),
+    makeZone("3D Enclosure 2", "ENC 2", 2, HEATER2_PIN, HEATER2_CH),
+}};
 
-FastPID fastPID1(2.0, 5.0, 1.0, 255, true);
-FastPID fastPID2(2.0, 5.0, 1.0, 255, true);
-bool tuning = false;
+std::array<FilamentBox, FILAMENT_BOX_COUNT> filamentBoxes = {{
+    {"Filament Box 1", "Fil 1", 0, 0, 0},
+    {"Filament Box 2", "Fil 2", 3, 0, 0},
+}};
+
+// What a reset must not lose, journalled by journalRunState() and
+// replayed by restoreRunState()
+enum RunFlags : uint8_t
+{
+  RUN_HEATING = 1,
+  RUN_TIMER = 2
+};
+
+struct ZoneRun
+{
+  int16_t setpoint; // tenths of a degree F
+  uint8_t flags;    // RunFlags
+  uint32_t timerSeconds;
+  uint32_t progress; // while heating: seconds left on a timer, or seconds of a manual run
+};
+
+struct RunState
+{
+  ZoneRun zone[ZONE_COUNT];
+};
+
+RunJournal<RunState, JOURNAL_SLOTS> runJournal(JOURNAL_EEPROM_ADDR, JOURNAL_VERSION);
+static_assert(JOURNAL_EEPROM_ADDR + RunJournal<RunState, JOURNAL_SLOTS>::STORAGE_BYTES <= EEPROM_SIZE, "EEPROM_SIZE too small for the run journal");
+RunState journalled = {}; // last state handed to runJournal, UI task
+
+bool humidityHigh[HUMIDITY_SLOTS] = {};
+TrendHistory<HISTORY_BUCKETS> history[HUMIDITY_SLOTS]; // UI task, by humidity slot
+uint8_t activeSlot = 0; // zone or filament box the shared screens act on
+
+// Display controller state, see updateScreen()
+enum DisplayState : uint8_t
+{
+  DISPLAY_ACTIVE,
+  DISPLAY_IDLE, // status rotation
+  DISPLAY_ASLEEP
+};
+
+#define IDLE_VIEWS (1 + ZONE_COUNT) // filament boxes, then each zone
 
 unsigned long lastInteraction = 0;
 unsigned long lastScreenSwitch = 0;
-bool inIdleMode = false;
-bool buzzerLocked = false;
+unsigned long lastFrame = 0;
+DisplayState displayState = DISPLAY_ACTIVE;
+uint8_t idleView = 0;
+bool frameRequested = true; // draw on the next tick regardless of the cap
+// Per-zone timer events, see startZoneTimer() and checkTimers()
+enum TimerEvent : uint8_t
+{
+  TIMER_FIVE_MIN,  // 5 minutes left
+  TIMER_COUNTDOWN, // 30 s left
+  TIMER_EXPIRED,
+  TIMER_RUNTIME_LIMIT, // manual mode, MAX_MANUAL_RUNTIME_SECONDS reached
+  TIMER_EVENT_COUNT
+};
+
+typedef EventQueue<ZONE_COUNT * TIMER_EVENT_COUNT> TimerEvents;
+TimerEvents timerEvents; // UI task only, owner = zone index
+
+bool overheatActive = false;
+unsigned long alarmStart = 0; // flash phase of the overheat / fault screen
+const Zone *heldZone = nullptr; // "View Temp" shows this zone until heldZoneUntil
+unsigned long heldZoneUntil = 0;
+
+// Buzzer patterns, indexed by BuzzerAlert
+const uint16_t CLICK_STEPS[] = {20};
+const uint16_t HUMIDITY_STEPS[] = {100, 100, 100};
+const uint16_t FIVE_MIN_STEPS[] = {500};
+const uint16_t COUNTDOWN_STEPS[] = {150, 150, 150, 150, 150, 150, 150, 650, 1000};
+const uint16_t RUNAWAY_STEPS[] = {300, 200};
+
+const BuzzerPattern BUZZER_PATTERNS[BUZZ_ALERT_COUNT] = {
+    {CLICK_STEPS, 1, false, false},    // BUZZ_CLICK: stale clicks are dropped
+    {HUMIDITY_STEPS, 3, false, true},  // BUZZ_HUMIDITY
+    {FIVE_MIN_STEPS, 1, false, true},  // BUZZ_FIVE_MIN
+    {COUNTDOWN_STEPS, 9, false, true}, // BUZZ_TIMER_END
+    {RUNAWAY_STEPS, 2, true, true},    // BUZZ_RUNAWAY
+};
+
+Buzzer buzzer(BUZZER_PIN, true, BUZZER_PATTERNS); // active LOW
 
 // Forward declarations for functions
-void displayMainMenu();
-void displaySettingsMenu();
 void displayZone(const Zone &z);
 void displayFilament();
 void displayAllTemps();
-void displayTimerDuration(const Zone &z);
 void displayCountdown(const Zone &z);
-void updateScreen();
+bool updateScreen();
+bool wakeDisplay();
+bool alarmActive();
+void enterScreen(uint8_t id);
+void sampleSensors();
+void controlStep();
+void controlPeriod();
+void handleInput();
+void onEncoderDetent(void *arg, int8_t direction);
+void refreshDisplay();
+void checkTimers();
+void startZoneTimer(uint8_t zone);
+void armZoneTimer(uint8_t zone, unsigned long remainingSeconds);
+void startZoneManual(uint8_t zone);
+void scheduleRuntimeLimit(uint8_t zone);
+void checkHumidityAlarms();
+void recordHistory();
+void syncControlState();
+void sendControlCommand(ControlCommandType type, uint8_t zone, int32_t value);
+void commitSettings(bool now);
+void handleSerial();
+void sendTelemetry();
+#if ENABLE_NETWORK
+void shareNetStatus();
+void applyTimerCommands();
+void networkTask(void *arg);
+#endif
+void printStats();
+void renderScreen();
+void controlTask(void *arg);
+void uiTask(void *arg);
 
-void displayMainMenu()
+uint8_t zoneIndex(const Zone &z)
 {
-  int enclosureMenuIndex = 0;
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print("MAIN MENU:");
-  const char *items[] = {
-      "3D Enclosure 1",
-      "3D Enclosure 2",
-      "Filament Box 1",
-      "Filament Box 2",
-      "All Sensors",
-      "SHUT ALL OFF",
-      "Settings"};
-  for (int i = 0; i < 7; i++)
-  {
-    u8g2.setCursor(0, 24 + i * 10);
-    u8g2.print((i == mainMenuIndex) ? "> " : "  ");
-    u8g2.print(items[i]);
-  }
-  u8g2.sendBuffer();
+  return (uint8_t)(&z - zones.data());
 }
 
-void displaySettingsMenu()
+// Latest control-task readings for a zone, as seen by the UI
+const ZoneStatus &statusOf(const Zone &z)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print("SETTINGS MENU:");
-  const char *settings[] = {
-      "Auto-Tune ENC 1",
-      "Auto-Tune ENC 2",
-      "Toggle Auto-OFF",
-      "Beep on Push"};
-  for (int i = 0; i < 6; i++)
-  {
-    u8g2.setCursor(0, 28 + i * 10);
-    u8g2.print((i == settingsMenuIndex) ? "> " : "  ");
-    u8g2.print(settings[i]);
-  }
-  u8g2.sendBuffer();
+  return view.zone[zoneIndex(z)];
 }
 
-void displayZone(const Zone &z)
+const char *slotName(uint8_t slot)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print(z.name);
-  u8g2.setCursor(0, 28);
-  u8g2.print("Temp: ");
-  u8g2.print(z.currentTemp);
-  u8g2.print(" F");
-
-  // Display humidity for corresponding enclosure channel
-  int ch = (z.name.indexOf("1") >= 0) ? 1 : 2;
-  float hum = 0;
-  tca.openChannel(ch);
-  if (sensor.begin())
-    hum = sensor.readHumidity();
-  tca.closeChannel(ch);
-
-  u8g2.setCursor(0, 40);
-  u8g2.print("Humidity: ");
-  u8g2.print(hum);
-  u8g2.print(" %");
-
-  u8g2.setCursor(0, 52);
-  if ((z.name.indexOf("1") >= 0 && hum > humidityLimit1 && humidityAlarm1) ||
-      (z.name.indexOf("2") >= 0 && hum > humidityLimit2 && humidityAlarm2))
-  {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 24);
-    u8g2.print("HIGH HUMIDITY!");
-    u8g2.setCursor(0, 44);
-    u8g2.print(z.name);
-    u8g2.sendBuffer();
-    delay(500);
-    u8g2.clear();
-    u8g2.sendBuffer();
-    delay(300);
-  }
-  u8g2.setCursor(0, 56);
-  u8g2.print("Heater: ");
-  u8g2.print(z.heaterOn ? "ON" : "OFF");
-  u8g2.sendBuffer();
+  return (slot < ZONE_COUNT) ? zones[slot].name : filamentBoxes[slot - ZONE_COUNT].name;
 }
 
-void displayFilament()
+const char *slotLabel(uint8_t slot)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print("Filament Temps:");
-  u8g2.setCursor(0, 28);
-  u8g2.print("Box 1: ");
-  u8g2.print(filamentTemp);
-  u8g2.print(" F");
-  u8g2.setCursor(0, 44);
-  u8g2.print("Box 2: ");
-  u8g2.print(filamentTemp2);
-  u8g2.print(" F");
-  u8g2.sendBuffer();
+  return (slot < ZONE_COUNT) ? zones[slot].label : filamentBoxes[slot - ZONE_COUNT].label;
 }
 
-void displayAllTemps()
+uint8_t resolveSlot(uint8_t slot)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print("ALL TEMPS:");
-  u8g2.setCursor(0, 28);
-  u8g2.print("Fil 1: ");
-  u8g2.print(filamentTemp);
-  u8g2.print(" F");
-  u8g2.setCursor(0, 38);
-  u8g2.print("Fil 2: ");
-  u8g2.print(filamentTemp2);
-  u8g2.print(" F");
-  u8g2.setCursor(0, 48);
-  u8g2.print("ENC 1: ");
-  u8g2.print(enclosure1.currentTemp);
-  u8g2.print(" F");
-  u8g2.setCursor(0, 58);
-  u8g2.print("ENC 2: ");
-  u8g2.print(enclosure2.currentTemp);
-  u8g2.print(" F");
-  u8g2.sendBuffer();
-}
-
-void displayTimerDuration(const Zone &z)
+  return (slot == SLOT_ACTIVE) ? activeSlot : slot;
+}
+
+int16_t slotTemp(uint8_t slot)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print("Set Timer:");
-  u8g2.setCursor(0, 28);
-  unsigned long sec = z.timerSeconds;
-  u8g2.print(sec / 3600);
-  u8g2.print("h ");
-  u8g2.print((sec % 3600) / 60);
-  u8g2.print("m");
-  u8g2.sendBuffer();
+  return (slot < ZONE_COUNT) ? view.zone[slot].temp : view.filamentTemp[slot - ZONE_COUNT];
 }
 
-void displayCountdown(const Zone &z)
+int16_t slotHumidity(uint8_t slot)
 {
-  u8g2.clearBuffer();
-  u8g2.setFont(u8g2_font_ncenB08_tr);
-  u8g2.setCursor(0, 12);
-  u8g2.print(z.name);
-  u8g2.setCursor(0, 28);
-  u8g2.print("RUNNING (Timer):");
-  unsigned long elapsed = (millis() - z.timerStart) / 1000UL;
-  unsigned long remaining = (z.timerSeconds > elapsed) ? (z.timerSeconds - elapsed) : 0;
-  u8g2.setCursor(0, 44);
-  u8g2.print("Time Left: ");
-  u8g2.print(remaining / 3600);
-  u8g2.print("h ");
-  u8g2.print((remaining % 3600) / 60);
-  u8g2.print("m");
-  u8g2.sendBuffer();
+  return (slot < ZONE_COUNT) ? view.zone[slot].humidity : view.filamentHumidity[slot - ZONE_COUNT];
 }
 
-void updateScreen()
+// Display text, reformatted only when the value behind it changes
+TextCache slotTempText[HUMIDITY_SLOTS]; // "72.5 F"
+TextCache zoneTempText[ZONE_COUNT];     // "Temp: 72.5 F"
+TextCache zoneHumidityText[ZONE_COUNT];
+TextCache zoneHeaterText[ZONE_COUNT];
+TextCache countdownText[ZONE_COUNT];
+TextCache gainText[3];
+TextCache editorText; // invalidated by enterScreen()
+
+char *formatDegrees(char *out, int32_t tenths)
 {
-  // This is a placeholder for any screen update logic
-  // You can implement this based on your needs
+  return appendText(appendTenths(out, tenths), " F");
 }
 
-void setup()
+char *formatTempLine(char *out, int32_t tenths)
 {
-  EEPROM.get(0, humidityLimit1);
-  EEPROM.get(4, humidityLimit2);
-  EEPROM.get(8, humidityLimitF1);
-  EEPROM.get(12, humidityLimitF2);
-  EEPROM.get(16, humidityAlarm1);
-  EEPROM.get(17, humidityAlarm2);
-  EEPROM.get(18, humidityAlarmF1);
-  EEPROM.get(19, humidityAlarmF2);
-  Serial.begin(115200);
-  Wire.begin();
-  tca.begin();
-  EEPROM.begin(EEPROM_SIZE);
-  u8g2.begin();
+  return formatDegrees(appendText(out, "Temp: "), tenths);
+}
 
-  pinMode(BUZZER_PIN, OUTPUT);
-  digitalWrite(BUZZER_PIN, HIGH);
-  pinMode(ENCODER_SW, INPUT_PULLUP);
-  pinMode(BACK_BUTTON, INPUT_PULLUP);
+char *formatHumidityLine(char *out, int32_t tenths)
+{
+  return appendText(appendTenths(appendText(out, "Humidity: "), tenths), " %");
+}
 
-  ledcSetup(HEATER1_CH, PWM_FREQ, PWM_RES);
-  ledcAttachPin(HEATER1_PIN, HEATER1_CH);
-  ledcSetup(HEATER2_CH, PWM_FREQ, PWM_RES);
-  ledcAttachPin(HEATER2_PIN, HEATER2_CH);
+// state = fault << 1 | heaterOn
+char *formatHeaterLine(char *out, int32_t state)
+{
+  out = appendText(out, "Heater: ");
+  if (state >> 1)
+    return appendText(out, RunawayDetector::describe(state >> 1)); // cleared by restarting the zone
+  return appendText(out, (state & 1) ? "ON" : "OFF");
+}
 
-  enclosure1.pid = new PID(&enclosure1.input, &enclosure1.output, &enclosure1.setpoint, 2.0, 5.0, 1.0, DIRECT);
-  enclosure2.pid = new PID(&enclosure2.input, &enclosure2.output, &enclosure2.setpoint, 2.0, 5.0, 1.0, DIRECT);
-  enclosure1.pid->SetMode(AUTOMATIC);
-  enclosure2.pid->SetMode(AUTOMATIC);
-  enclosure1.pid->SetOutputLimits(0, 255);
-  enclosure2.pid->SetOutputLimits(0, 255);
+char *formatTimeLeft(char *out, int32_t seconds)
+{
+  return appendDuration(appendText(out, "Time Left: "), seconds);
+}
 
-  lastInteraction = millis();
-  Serial.println("System initialized.");
+char *formatInt(char *out, int32_t value)
+{
+  return appendFixed(out, value, 0);
 }
 
-void loop()
+char *formatDurationValue(char *out, int32_t seconds)
 {
-  // Read all sensors
-  tca.openChannel(0);
-  if (sensor.begin())
-    filamentTemp = sensor.readTemperature();
-  tca.closeChannel(0);
-  tca.openChannel(3);
-  if (sensor.begin())
-    filamentTemp2 = sensor.readTemperature();
-  tca.closeChannel(3);
-  tca.openChannel(1);
-  if (sensor.begin())
-    enclosure1.currentTemp = sensor.readTemperature();
-  tca.closeChannel(1);
-  tca.openChannel(2);
-  if (sensor.begin())
-    enclosure2.currentTemp = sensor.readTemperature();
-  tca.closeChannel(2);
-
-  // PID control if not tuning
-  if (!tuning)
-  {
-    enclosure1.input = enclosure1.currentTemp;
-    enclosure2.input = enclosure2.currentTemp;
-
-    if (enclosure1.currentTemp >= 130.0 || enclosure2.currentTemp >= 130.0)
-    {
-      Serial.println("!! OVERHEAT DETECTED — SYSTEM SHUTDOWN !!");
-      enclosure1.heaterOn = false;
-      enclosure2.heaterOn = false;
-      ledcWrite(HEATER1_CH, 0);
-      ledcWrite(HEATER2_CH, 0);
+  return appendDuration(out, seconds);
+}
 
-      for (int i = 0; i < 3; i++)
-      {
-        u8g2.clearBuffer();
-        u8g2.setFont(u8g2_font_ncenB08_tr);
-        u8g2.setCursor(0, 24);
-        u8g2.print("!!! OVERHEAT !!!");
-        u8g2.setCursor(0, 44);
-        u8g2.print("SYSTEM SHUTDOWN");
-        u8g2.sendBuffer();
-        delay(500);
-        u8g2.clear();
-        u8g2.sendBuffer();
-        delay(300);
-      }
+char *formatGain(char *out, int32_t hundredths)
+{
+  return appendFixed(out, hundredths, 2);
+}
 
-      for (int i = 0; i < 10; i++)
-      {
-        digitalWrite(BUZZER_PIN, LOW);
-        delay(300);
-        digitalWrite(BUZZER_PIN, HIGH);
-        delay(200);
-      }
-      buzzerLocked = true;
-    }
-    else
-    {
-      enclosure1.input = enclosure1.currentTemp;
-      enclosure1.output = fastPID1.step(enclosure1.input, enclosure1.setpoint);
-      enclosure1.heaterOn = true;
-
-      enclosure2.input = enclosure2.currentTemp;
-      enclosure2.output = fastPID2.step(enclosure2.input, enclosure2.setpoint);
-      enclosure2.heaterOn = true;
-      ledcWrite(HEATER1_CH, (int)enclosure1.output);
-      ledcWrite(HEATER2_CH, (int)enclosure2.output);
-    }
+// "<label>: <value>" starting at the left edge
+void drawLabelled(u8g2_uint_t y, const char *label, const char *value)
+{
+  u8g2_uint_t x = u8g2.drawStr(0, y, label);
+  x += u8g2.drawStr(x, y, ": ");
+  u8g2.drawStr(x, y, value);
+}
+
+// The render functions below draw into a buffer refreshDisplay() has
+// already cleared and set to the regular font, and leave the flush to it.
+
+void displayZone(const Zone &z)
+{
+  const uint8_t i = zoneIndex(z);
+  const ZoneStatus &st = view.zone[i];
+  if (humidityHigh[i] && millis() % 800 < 500)
+  {
+    // Flash the warning in place of the zone page (500 ms on, 300 ms off)
+    u8g2.drawStr(0, 24, "HIGH HUMIDITY!");
+    u8g2.drawStr(0, 44, z.name);
+    return;
   }
+  u8g2.drawStr(0, 12, z.name);
+  u8g2.drawStr(0, 28, zoneTempText[i].get(st.temp, formatTempLine));
+  u8g2.drawStr(0, 40, zoneHumidityText[i].get(st.humidity, formatHumidityLine));
+  u8g2.drawStr(0, 56, zoneHeaterText[i].get(st.fault << 1 | st.heaterOn, formatHeaterLine));
+}
 
-  // Encoder navigation
-  long newPos = encoder.read() / 4;
-  if (newPos != lastEncoderPos)
+void displayFilament()
+{
+  u8g2.drawStr(0, 12, "Filament Temps:");
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++)
   {
-    lastEncoderPos = newPos;
-    lastInteraction = millis();
-    if (screenIndex == 100)
-      mainMenuIndex = abs(newPos) % 7;
-    else if (screenIndex == 99)
-      settingsMenuIndex = abs(newPos) % 4;
+    const uint8_t slot = ZONE_COUNT + i;
+    drawLabelled(28 + i * 16, slotLabel(slot), slotTempText[slot].get(slotTemp(slot), formatDegrees));
   }
+}
 
-  // Encoder button press
-  if (digitalRead(ENCODER_SW) == LOW && !encoderButtonPressed)
+void displayAllTemps()
+{
+  // Four rows fit the regular font; squeeze bigger setups into a small one
+  const uint8_t rows = FILAMENT_BOX_COUNT + ZONE_COUNT;
+  const uint8_t step = (rows <= 4) ? 10 : 36 / (rows - 1);
+  u8g2.drawStr(0, 12, "ALL TEMPS:");
+  if (rows > 4)
+    u8g2.setFont(u8g2_font_5x7_tr);
+  for (uint8_t row = 0; row < rows; row++)
   {
-    if (beepOnPush)
-    {
-      digitalWrite(BUZZER_PIN, LOW);
-      delay(20);
-      digitalWrite(BUZZER_PIN, HIGH);
-    }
-    encoderButtonPressed = true;
-    if (screenIndex == 100)
-    {
-      switch (mainMenuIndex)
-      {
-      case 0:
-        screenIndex = 10;
-        break;
-      case 1:
-        screenIndex = 11;
-        break;
-      case 2:
-        screenIndex = 12;
-        break;
-      case 3:
-        screenIndex = 13;
-        break;
-      case 4:
-        screenIndex = 3;
-        break;
-      case 5:
-        ledcWrite(HEATER1_CH, 0);
-        ledcWrite(HEATER2_CH, 0);
-        break;
-      case 6:
-        screenIndex = 99;
-        break;
-      }
-    }
-    else if (screenIndex == 12)
-    {
-      switch (lastEncoderPos % 2)
-      {
-      case 0:
-        screenIndex = 26;
-        break;
-      case 1:
-        humidityAlarmF1 = !humidityAlarmF1;
-        EEPROM.put(18, humidityAlarmF1);
-        EEPROM.commit();
-        break;
-      }
-    }
-    else if (screenIndex == 13)
-    {
-      switch (lastEncoderPos % 2)
-      {
-      case 0:
-        screenIndex = 36;
-        break;
-      case 1:
-        humidityAlarmF2 = !humidityAlarmF2;
-        EEPROM.put(19, humidityAlarmF2);
-        EEPROM.commit();
-        break;
-      }
-    }
-    else if (screenIndex == 10)
+    // Filament boxes first, then the enclosures
+    const uint8_t slot = (row < FILAMENT_BOX_COUNT) ? ZONE_COUNT + row : row - FILAMENT_BOX_COUNT;
+    drawLabelled(28 + row * step, slotLabel(slot), slotTempText[slot].get(slotTemp(slot), formatDegrees));
+  }
+}
+
+// One sparkline row per channel covering the whole kept history. Each
+// column is the min..max band of the buckets it stands for, and every row
+// is scaled to its own range.
+void displayTrends(bool humidity)
+{
+  const uint8_t rowHeight = 64 / HUMIDITY_SLOTS;
+  const uint8_t x0 = 28;
+  const uint8_t width = 128 - x0;
+  u8g2.setFont(u8g2_font_5x7_tr);
+  for (uint8_t slot = 0; slot < HUMIDITY_SLOTS; slot++)
+  {
+    const TrendHistory<HISTORY_BUCKETS> &h = history[slot];
+    const uint8_t top = slot * rowHeight;
+    u8g2.drawStr(0, top + rowHeight / 2 + 3, slotLabel(slot));
+
+    uint16_t n = h.size();
+    if (n == 0)
+      continue;
+    int16_t lo = INT16_MAX, hi = INT16_MIN;
+    for (uint16_t i = 0; i < n; i++)
     {
-      switch (lastEncoderPos % 6)
-      {
-      case 0:
-        screenIndex = 24;
-        break;
-      case 1:
-        enclosure1.useTimer = !enclosure1.useTimer;
-        break;
-      case 2:
-        screenIndex = 20;
-        break;
-      case 3:
-        screenIndex = 10;
-        displayZone(enclosure1);
-        delay(1000);
-        break;
-      case 4:
-        screenIndex = 25;
-        break;
-      case 5:
-        humidityAlarm1 = !humidityAlarm1;
-        EEPROM.put(16, humidityAlarm1);
-        EEPROM.commit();
-        break;
-      }
+      const TrendHistory<HISTORY_BUCKETS>::Bucket &b = h.at(i);
+      lo = min(lo, humidity ? b.avgHumidity : b.minTemp);
+      hi = max(hi, humidity ? b.avgHumidity : b.maxTemp);
     }
-    else if (screenIndex == 11)
-    {
-      switch (lastEncoderPos % 6)
-      {
-      case 0:
-        screenIndex = 34;
-        break;
-      case 1:
-        enclosure2.useTimer = !enclosure2.useTimer;
-        break;
-      case 2:
-        screenIndex = 30;
-        break;
-      case 3:
-        screenIndex = 11;
-        displayZone(enclosure2);
-        delay(1000);
-        break;
-      case 4:
-        screenIndex = 35;
-        break;
-      case 5:
-        humidityAlarm2 = !humidityAlarm2;
-        EEPROM.put(17, humidityAlarm2);
-        EEPROM.commit();
-        break;
-      }
+    if (hi - lo < 10)
+    { // keep flat traces mid-row instead of magnifying noise
+      int16_t mid = (lo + hi) / 2;
+      lo = mid - 5;
+      hi = mid + 5;
     }
-    else if (screenIndex == 99)
+
+    const uint8_t columns = (n < width) ? n : width;
+    const int16_t bottom = top + rowHeight - 2;
+    const int16_t span = rowHeight - 3;
+    for (uint8_t c = 0; c < columns; c++)
     {
-      if (settingsMenuIndex == 0 && !tuning)
+      uint16_t first = (uint32_t)c * n / columns;
+      uint16_t last = (uint32_t)(c + 1) * n / columns;
+      int16_t colLo = INT16_MAX, colHi = INT16_MIN;
+      for (uint16_t i = first; i < last; i++)
       {
-        Serial.println("FastPID tuning is not dynamic — settings are applied statically.");
+        const TrendHistory<HISTORY_BUCKETS>::Bucket &b = h.at(i);
+        colLo = min(colLo, humidity ? b.avgHumidity : b.minTemp);
+        colHi = max(colHi, humidity ? b.avgHumidity : b.maxTemp);
       }
-      else if (settingsMenuIndex == 1 && !tuning)
-      {
-        Serial.println("FastPID tuning is not dynamic — settings are applied statically.");
-      }
-      else if (settingsMenuIndex == 2)
-        autoShutoffEnabled = !autoShutoffEnabled;
-      else if (settingsMenuIndex == 3)
-        beepOnPush = !beepOnPush;
+      int16_t yLo = bottom - (int32_t)(colLo - lo) * span / (hi - lo);
+      int16_t yHi = bottom - (int32_t)(colHi - lo) * span / (hi - lo);
+      u8g2.drawVLine(x0 + c, yHi, yLo - yHi + 1);
     }
   }
-  else if (digitalRead(ENCODER_SW) == HIGH)
-    encoderButtonPressed = false;
+}
 
-  if (digitalRead(BACK_BUTTON) == LOW && !backButtonPressed)
-  {
-    backButtonPressed = true;
-    screenIndex = 100;
-  }
-  else if (digitalRead(BACK_BUTTON) == HIGH)
-    backButtonPressed = false;
+// Seconds left on a zone's timer, 0 once it has run out
+unsigned long timerRemaining(const Zone &z)
+{
+  return secondsUntil(z.timerStart + z.timerSeconds * 1000UL, millis());
+}
+
+void displayCountdown(const Zone &z)
+{
+  u8g2.drawStr(0, 12, z.name);
+  u8g2.drawStr(0, 28, "RUNNING (Timer):");
+  u8g2.drawStr(0, 44, countdownText[zoneIndex(z)].get(timerRemaining(z), formatTimeLeft));
+}
+
+void renderAllTemps(uint8_t)
+{
+  displayAllTemps();
+}
+
+// slot 0 = temperature, 1 = humidity
+void renderTrends(uint8_t slot)
+{
+  displayTrends(slot == 1);
+}
+
+void renderCountdown(uint8_t slot)
+{
+  displayCountdown(zones[slot]);
+}
 
-  // Update screen
-  switch (screenIndex)
+void renderAutotune(uint8_t slot)
+{
+  const ZoneStatus &st = view.zone[slot];
+  u8g2_uint_t x = u8g2.drawStr(0, 12, "Tune ");
+  u8g2.drawStr(x, 12, zones[slot].name);
+  switch (st.tuneState)
   {
-  case 100:
-    displayMainMenu();
+  case RelayAutoTune::RUNNING:
+    u8g2.drawStr(0, 28, zoneTempText[slot].get(st.temp, formatTempLine));
+    u8g2.drawFrame(0, 36, 128, 10);
+    u8g2.drawBox(2, 38, 124 * st.tuneProgress / 100, 6);
+    u8g2.drawStr(0, 60, "Back: tuning continues");
     break;
-  case 99:
-    displaySettingsMenu();
+  case RelayAutoTune::DONE:
+    drawLabelled(28, "Kp", gainText[0].get(lroundf(st.gains.kp * 100), formatGain));
+    drawLabelled(40, "Ki", gainText[1].get(lroundf(st.gains.ki * 100), formatGain));
+    drawLabelled(52, "Kd", gainText[2].get(lroundf(st.gains.kd * 100), formatGain));
     break;
-  case 10:
-  {
-    const char *enc1menu[] = {"Set Temp", "Toggle Mode", "Set Timer", "View Temp", "Set Humidity Alert", "Toggle Humidity Alarm"};
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 12);
-    u8g2.print("Enclosure 1 Menu:");
-    for (int i = 0; i < 4; i++)
-    {
-      u8g2.setCursor(0, 28 + i * 10);
-      u8g2.print((i == (lastEncoderPos % 4)) ? "> " : "  ");
-      u8g2.print(enc1menu[i]);
-    }
-    u8g2.sendBuffer();
+  case RelayAutoTune::FAILED:
+    u8g2.drawStr(0, 32, "Tuning failed,");
+    u8g2.drawStr(0, 44, "gains unchanged");
+    break;
+  default:
+    u8g2.drawStr(0, 32, "Not running");
     break;
   }
-  case 11:
+}
+
+// ---------------------------------------------------------------------------
+// Menu tables. Everything the UI can show is described here; renderMenu(),
+// renderEditor() and handleInput() are generic over these descriptors.
+
+constexpr MenuItem MAIN_ITEMS[] = {
+    {"3D Enclosure 1", ITEM_SCREEN, SCREEN_ZONE, 0},
+    {"3D Enclosure 2", ITEM_SCREEN, SCREEN_ZONE, 1},
+    {"Filament Box 1", ITEM_SCREEN, SCREEN_FBOX, ZONE_COUNT + 0},
+    {"Filament Box 2", ITEM_SCREEN, SCREEN_FBOX, ZONE_COUNT + 1},
+    {"All Sensors", ITEM_SCREEN, SCREEN_ALL_TEMPS, 0},
+    {"Temp Trends", ITEM_SCREEN, SCREEN_TEMP_TRENDS, 0},
+    {"Humidity Trends", ITEM_SCREEN, SCREEN_HUMIDITY_TRENDS, 0},
+    {"SHUT ALL OFF", ITEM_ACTION, ACTION_SHUT_ALL_OFF, 0},
+    {"Settings", ITEM_SCREEN, SCREEN_SETTINGS, 0}};
+
+constexpr MenuItem SETTINGS_ITEMS[] = {
+    {"Auto-Tune ENC 1", ITEM_ACTION, ACTION_AUTOTUNE, 0},
+    {"Auto-Tune ENC 2", ITEM_ACTION, ACTION_AUTOTUNE, 1},
+    {"Toggle Auto-OFF", ITEM_ACTION, ACTION_TOGGLE_AUTO_OFF, 0},
+    {"Beep on Push", ITEM_ACTION, ACTION_TOGGLE_BEEP, 0}};
+
+// Shared by every zone / filament box; SLOT_ACTIVE is the one picked in MAIN_ITEMS
+constexpr MenuItem ZONE_ITEMS[] = {
+    {"Set Temp", ITEM_SCREEN, SCREEN_ZONE_TEMP, SLOT_ACTIVE},
+    {"Toggle Mode", ITEM_ACTION, ACTION_TOGGLE_MODE, SLOT_ACTIVE},
+    {"Set Timer", ITEM_SCREEN, SCREEN_ZONE_TIMER, SLOT_ACTIVE},
+    {"View Temp", ITEM_ACTION, ACTION_VIEW_ZONE, SLOT_ACTIVE},
+    {"Set Humidity Alert", ITEM_SCREEN, SCREEN_ZONE_HUMIDITY, SLOT_ACTIVE},
+    {"Toggle Humidity Alarm", ITEM_ACTION, ACTION_TOGGLE_HUMIDITY_ALARM, SLOT_ACTIVE}};
+
+constexpr MenuItem FBOX_ITEMS[] = {
+    {"Set Humidity Alert", ITEM_SCREEN, SCREEN_FBOX_HUMIDITY, SLOT_ACTIVE},
+    {"Toggle Humidity Alarm", ITEM_ACTION, ACTION_TOGGLE_HUMIDITY_ALARM, SLOT_ACTIVE}};
+
+// target, slot, min, count, step, unit, confirm screen
+constexpr ValueEditor TEMP_EDITOR = {EDIT_SETPOINT, SLOT_ACTIVE, 70, 51, 1, " F", SCREEN_ZONE}; // 70-120°F
+constexpr ValueEditor TIMER_EDITOR = {EDIT_TIMER, SLOT_ACTIVE, 1200, 289, 600, nullptr, SCREEN_ZONE_COUNTDOWN}; // 20 min to 48 h in 10 min steps
+constexpr ValueEditor ZONE_HUMIDITY_EDITOR = {EDIT_HUMIDITY_LIMIT, SLOT_ACTIVE, 30, 70, 1, " %", SCREEN_ZONE};
+constexpr ValueEditor FBOX_HUMIDITY_EDITOR = {EDIT_HUMIDITY_LIMIT, SLOT_ACTIVE, 30, 70, 1, " %", SCREEN_FBOX};
+
+#define ITEMS(a) a, (uint8_t)(sizeof(a) / sizeof(a[0]))
+
+// Indexed by ScreenId: kind, title (nullptr = slot name), parent, items,
+// item count, editor, render, slot
+constexpr ScreenDesc SCREENS[] = {
+    {SCREEN_KIND_MENU, "MAIN MENU:", SCREEN_MAIN, ITEMS(MAIN_ITEMS), nullptr, nullptr, 0},
+    {SCREEN_KIND_MENU, "SETTINGS MENU:", SCREEN_MAIN, ITEMS(SETTINGS_ITEMS), nullptr, nullptr, 0},
+    {SCREEN_KIND_MENU, nullptr, SCREEN_MAIN, ITEMS(ZONE_ITEMS), nullptr, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_MENU, nullptr, SCREEN_MAIN, ITEMS(FBOX_ITEMS), nullptr, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_VIEW, "ALL TEMPS:", SCREEN_MAIN, nullptr, 0, nullptr, renderAllTemps, 0},
+    {SCREEN_KIND_VIEW, "TEMP TRENDS", SCREEN_MAIN, nullptr, 0, nullptr, renderTrends, 0},
+    {SCREEN_KIND_VIEW, "HUMIDITY TRENDS", SCREEN_MAIN, nullptr, 0, nullptr, renderTrends, 1},
+    {SCREEN_KIND_EDITOR, "Set Temp:", SCREEN_ZONE, nullptr, 0, &TEMP_EDITOR, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_EDITOR, "Set Timer:", SCREEN_ZONE, nullptr, 0, &TIMER_EDITOR, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_VIEW, "Countdown", SCREEN_ZONE, nullptr, 0, nullptr, renderCountdown, SLOT_ACTIVE},
+    {SCREEN_KIND_EDITOR, "Humidity Alert:", SCREEN_ZONE, nullptr, 0, &ZONE_HUMIDITY_EDITOR, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_EDITOR, "Humidity Alert:", SCREEN_FBOX, nullptr, 0, &FBOX_HUMIDITY_EDITOR, nullptr, SLOT_ACTIVE},
+    {SCREEN_KIND_VIEW, "Auto-Tune", SCREEN_SETTINGS, nullptr, 0, nullptr, renderAutotune, SLOT_ACTIVE}};
+#undef ITEMS
+
+static_assert(sizeof(SCREENS) / sizeof(SCREENS[0]) == SCREEN_COUNT, "SCREENS needs one entry per ScreenId");
+
+int32_t editorValueAt(const ValueEditor &ed, long pos)
+{
+  return ed.minValue + (int32_t)wrapIndex(pos, ed.count) * ed.step;
+}
+
+int32_t editorValue(const ValueEditor &ed)
+{
+  uint8_t slot = resolveSlot(ed.slot);
+  switch (ed.target)
   {
-    const char *enc2menu[] = {"Set Temp", "Toggle Mode", "Set Timer", "View Temp", "Set Humidity Alert", "Toggle Humidity Alarm"};
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 12);
-    u8g2.print("Enclosure 2 Menu:");
-    for (int i = 0; i < 4; i++)
-    {
-      u8g2.setCursor(0, 28 + i * 10);
-      u8g2.print((i == (lastEncoderPos % 4)) ? "> " : "  ");
-      u8g2.print(enc2menu[i]);
-    }
-    u8g2.sendBuffer();
-    break;
+  case EDIT_SETPOINT:
+    return zones[slot].targetTemp;
+  case EDIT_TIMER:
+    return (int32_t)zones[slot].timerSeconds;
+  case EDIT_HUMIDITY_LIMIT:
+    return settings.humidityLimit[slot];
   }
-  case 12:
+  return ed.minValue;
+}
+
+// Applied live on every detent. A timer's duration is the exception: it
+// only takes effect in confirmEditor(), which restarts the countdown with it.
+void applyEditor(const ValueEditor &ed, int32_t value)
+{
+  uint8_t slot = resolveSlot(ed.slot);
+  switch (ed.target)
   {
-    const char *f1menu[] = {"Set Humidity Alert", "Toggle Humidity Alarm"};
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 12);
-    u8g2.print("Filament Box 1:");
-    for (int i = 0; i < 2; i++)
+  case EDIT_SETPOINT:
+    if (value != zones[slot].targetTemp)
     {
-      u8g2.setCursor(0, 28 + i * 10);
-      u8g2.print((i == (lastEncoderPos % 2)) ? "> " : "  ");
-      u8g2.print(f1menu[i]);
+      zones[slot].targetTemp = value;
+      sendControlCommand(CMD_SET_SETPOINT, slot, value * 10);
     }
-    u8g2.sendBuffer();
     break;
-  }
-  case 13:
-  {
-    const char *f2menu[] = {"Set Humidity Alert", "Toggle Humidity Alarm"};
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 12);
-    u8g2.print("Filament Box 2:");
-    for (int i = 0; i < 2; i++)
+  case EDIT_TIMER:
+    break;
+  case EDIT_HUMIDITY_LIMIT:
+    if (value != settings.humidityLimit[slot])
     {
-      u8g2.setCursor(0, 28 + i * 10);
-      u8g2.print((i == (lastEncoderPos % 2)) ? "> " : "  ");
-      u8g2.print(f2menu[i]);
+      settings.humidityLimit[slot] = value;
+      settingsStore.markDirty();
     }
-    u8g2.sendBuffer();
     break;
   }
-  case 14:
-    displayAllTemps();
-    break;
-  case 26:
+}
+
+void confirmEditor(const ValueEditor &ed)
+{
+  int32_t value = editorValueAt(ed, cursorPos);
+  applyEditor(ed, value);
+  if (ed.target == EDIT_TIMER)
   {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("FBox1 Humidity Alert:");
-    int limit = 30 + (abs(lastEncoderPos) % 70);
-    u8g2.setCursor(0, 40);
-    u8g2.print(limit);
-    u8g2.print(" %");
-    humidityLimitF1 = limit;
-    EEPROM.put(8, humidityLimitF1);
-    EEPROM.commit();
-    u8g2.sendBuffer();
-    break;
+    uint8_t zone = resolveSlot(ed.slot);
+    zones[zone].timerSeconds = value;
+    startZoneTimer(zone);
   }
-  case 36:
+  enterScreen(ed.confirmScreen);
+}
+
+void runAction(uint8_t action, uint8_t slot)
+{
+  switch (action)
   {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("FBox2 Humidity Alert:");
-    int limit = 30 + (abs(lastEncoderPos) % 70);
-    u8g2.setCursor(0, 40);
-    u8g2.print(limit);
-    u8g2.print(" %");
-    humidityLimitF2 = limit;
-    EEPROM.put(12, humidityLimitF2);
-    EEPROM.commit();
-    u8g2.sendBuffer();
+  case ACTION_SHUT_ALL_OFF:
+    sendControlCommand(CMD_ALL_OFF, 0, 0);
     break;
-  }
-  case 23:
-    displayCountdown(enclosure1);
+  case ACTION_AUTOTUNE:
+    sendControlCommand(CMD_AUTOTUNE, slot, 0);
+    activeSlot = slot;
+    enterScreen(SCREEN_ZONE_AUTOTUNE);
     break;
-  case 33:
-    displayCountdown(enclosure2);
+  case ACTION_TOGGLE_MODE:
+    // Timer mode only takes over once a duration is confirmed in the timer
+    // editor; until then the manual run (and its runtime limit) carries on,
+    // and toggling again drops the pending choice
+    if (zones[slot].useTimer)
+      startZoneManual(slot);
+    else if (zones[slot].pendingTimerMode)
+      zones[slot].pendingTimerMode = false;
+    else
+    {
+      zones[slot].pendingTimerMode = true;
+      activeSlot = slot;
+      enterScreen(SCREEN_ZONE_TIMER);
+    }
     break;
-  case 24:
-  {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("Set ENC1 Temp:");
-    int tempSet = 70 + (abs(lastEncoderPos) % 51); // 70-120°F
-    u8g2.setCursor(0, 40);
-    u8g2.print(tempSet);
-    u8g2.print(" F");
-    enclosure1.setpoint = tempSet;
-    u8g2.sendBuffer();
+  case ACTION_VIEW_ZONE:
+    heldZone = &zones[slot];
+    heldZoneUntil = millis() + 1000;
     break;
-  }
-  case 34:
-  {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("Set ENC2 Temp:");
-    int tempSet = 70 + (abs(lastEncoderPos) % 51);
-    u8g2.setCursor(0, 40);
-    u8g2.print(tempSet);
-    u8g2.print(" F");
-    enclosure2.setpoint = tempSet;
-    u8g2.sendBuffer();
+  case ACTION_TOGGLE_HUMIDITY_ALARM:
+    settings.humidityAlarm[slot] = !settings.humidityAlarm[slot];
+    settingsStore.markDirty();
     break;
-  }
-  case 25:
-  {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("ENC1 Humidity Alert:");
-    int limit = 30 + (abs(lastEncoderPos) % 70);
-    u8g2.setCursor(0, 40);
-    u8g2.print(limit);
-    u8g2.print(" %");
-    humidityLimit1 = limit;
-    EEPROM.put(0, humidityLimit1);
-    EEPROM.commit();
-    u8g2.sendBuffer();
+  case ACTION_TOGGLE_AUTO_OFF:
+    settings.autoShutoffEnabled = !settings.autoShutoffEnabled;
+    settingsStore.markDirty();
+    for (uint8_t i = 0; i < ZONE_COUNT; i++)
+    {
+      if (!settings.autoShutoffEnabled || view.zone[i].heaterOn)
+        scheduleRuntimeLimit(i);
+    }
     break;
-  }
-  case 35:
-  {
-    u8g2.clearBuffer();
-    u8g2.setFont(u8g2_font_ncenB08_tr);
-    u8g2.setCursor(0, 20);
-    u8g2.print("ENC2 Humidity Alert:");
-    int limit = 30 + (abs(lastEncoderPos) % 70);
-    u8g2.setCursor(0, 40);
-    u8g2.print(limit);
-    u8g2.print(" %");
-    humidityLimit2 = limit;
-    EEPROM.put(4, humidityLimit2);
-    EEPROM.commit();
-    u8g2.sendBuffer();
+  case ACTION_TOGGLE_BEEP:
+    settings.beepOnPush = !settings.beepOnPush;
+    settingsStore.markDirty();
     break;
   }
-  case 20:
-  {
-    screenIndex = 21;
-    enclosure1.useTimer = !enclosure1.useTimer;
-    break;
+}
+
+void enterScreen(uint8_t id)
+{
+  if (id >= SCREEN_COUNT)
+    id = SCREEN_MAIN;
+  screenIndex = id;
+  commitSettings(true); // leaving a screen ends any edit in progress
+
+  // Menus open on their first item, editors on the current value
+  long pos = 0;
+  const ScreenDesc &sc = SCREENS[id];
+  if (sc.kind == SCREEN_KIND_EDITOR)
+  {
+    int32_t idx = (editorValue(*sc.editor) - sc.editor->minValue) / sc.editor->step;
+    pos = constrain(idx, (int32_t)0, (int32_t)sc.editor->count - 1);
   }
-  case 21:
+  cursorPos = pos;
+  editorText.invalidate(); // the next editor may format differently
+}
+
+void renderMenu(const ScreenDesc &sc)
+{
+  uint8_t cursor = wrapIndex(cursorPos, sc.itemCount);
+  // Scroll so the selected row is always visible
+  uint8_t first = (cursor >= MENU_VISIBLE_ROWS) ? cursor - MENU_VISIBLE_ROWS + 1 : 0;
+  u8g2.drawStr(0, 12, sc.title ? sc.title : slotName(resolveSlot(sc.slot)));
+  for (uint8_t row = 0; row < MENU_VISIBLE_ROWS && first + row < sc.itemCount; row++)
   {
-    enclosure1.timerSeconds = (abs(lastEncoderPos) % 289 + 2) * 600; // Fixed max() issue
-    displayTimerDuration(enclosure1);
-    break;
+    uint8_t i = first + row;
+    u8g2_uint_t x = u8g2.drawStr(0, 28 + row * 10, (i == cursor) ? "> " : "  ");
+    u8g2.drawStr(x, 28 + row * 10, sc.items[i].label);
   }
-  case 22:
+}
+
+void renderEditor(const ScreenDesc &sc)
+{
+  const ValueEditor &ed = *sc.editor;
+  int32_t value = editorValueAt(ed, cursorPos);
+  u8g2.drawStr(0, 12, slotName(resolveSlot(ed.slot)));
+  u8g2.drawStr(0, 28, sc.title);
+  // Editors with a unit show the plain number, the others a duration
+  u8g2_uint_t x = u8g2.drawStr(0, 46, editorText.get(value, ed.unit ? formatInt : formatDurationValue));
+  if (ed.unit)
+    u8g2.drawStr(x, 46, ed.unit);
+}
+
+void setPanelAsleep(bool asleep)
+{
+  I2cBus::Guard guard(i2c);
+  u8g2.setPowerSave(asleep ? 1 : 0);
+}
+
+// Display controller, ticked every DISPLAY_INTERVAL_MS. Picks the display
+// state from the time since the last input and returns whether a frame is
+// due:
+//   active  menus and editors, at most one frame per ACTIVE_FRAME_MS
+//   idle    after SCREEN_IDLE_TIMEOUT, rotating status views every
+//           SCREEN_SWITCH_INTERVAL at one frame per IDLE_FRAME_MS
+//   asleep  after SCREEN_SLEEP_TIMEOUT, panel in power-save, no frames
+// An overheat or heater fault keeps it active; input wakes it through
+// wakeDisplay(). Unchanged frames cost no I2C traffic either way (FrameDiff).
+bool updateScreen()
+{
+  unsigned long now = millis();
+  unsigned long quiet = now - lastInteraction;
+  DisplayState want = DISPLAY_ACTIVE;
+  if (!alarmActive())
   {
-    enclosure1.timerStart = millis();
-    enclosure1.heaterOn = true;
-    screenIndex = 23;
-    break;
+    if (quiet >= SCREEN_SLEEP_TIMEOUT)
+      want = DISPLAY_ASLEEP;
+    else if (quiet >= SCREEN_IDLE_TIMEOUT)
+      want = DISPLAY_IDLE;
   }
-  case 30:
+
+  if (want != displayState)
   {
-    screenIndex = 31;
-    enclosure2.useTimer = !enclosure2.useTimer;
-    break;
+    if (want == DISPLAY_ASLEEP)
+      setPanelAsleep(true);
+    else if (displayState == DISPLAY_ASLEEP)
+    {
+      setPanelAsleep(false);
+      oled.invalidate(); // RAM may not match our shadow after power-save
+    }
+    if (want == DISPLAY_IDLE)
+    {
+      idleView = 0;
+      lastScreenSwitch = now;
+    }
+    displayState = want;
+    frameRequested = true;
   }
-  case 31:
+
+  if (displayState == DISPLAY_ASLEEP)
+    return false;
+  if (displayState == DISPLAY_IDLE && now - lastScreenSwitch >= SCREEN_SWITCH_INTERVAL)
   {
-    enclosure2.timerSeconds = (abs(lastEncoderPos) % 289 + 2) * 600; // Fixed max() issue
-    displayTimerDuration(enclosure2);
-    break;
+    lastScreenSwitch = now;
+    idleView = (idleView + 1) % IDLE_VIEWS;
+    frameRequested = true;
   }
-  case 32:
+  unsigned long frameMs = (displayState == DISPLAY_IDLE) ? IDLE_FRAME_MS : ACTIVE_FRAME_MS;
+  if (!frameRequested && now - lastFrame < frameMs)
+    return false;
+  frameRequested = false;
+  lastFrame = now;
+  return true;
+}
+
+// Note user input: restarts the idle clock and asks for a frame on the
+// next tick. Returns true if the screen was idle or asleep, in which case
+// the input only wakes it.
+bool wakeDisplay()
+{
+  lastInteraction = millis();
+  frameRequested = true;
+  return displayState != DISPLAY_ACTIVE;
+}
+
+// Unattended status rotation: the filament boxes, then each zone, shown
+// as its countdown while a timer runs
+void renderIdle()
+{
+  if (idleView == 0)
   {
-    enclosure2.timerStart = millis();
-    enclosure2.heaterOn = true;
-    screenIndex = 33;
-    break;
+    displayFilament();
+    return;
   }
+  const Zone &z = zones[idleView - 1];
+  if (z.useTimer && statusOf(z).heaterOn)
+    displayCountdown(z);
+  else
+    displayZone(z);
+}
+
+// Pre-versioned firmware stored raw values: humidity limits as ints at
+// 0/4/8/12 and alarm flags at 16-19, for ENC 1, ENC 2, FBox 1 and FBox 2.
+// Adopt them if they look sane.
+bool migrateLegacySettings()
+{
+  Settings legacy = settings;
+  for (uint8_t i = 0; i < 4; i++)
+  {
+    int limit;
+    uint8_t alarm;
+    EEPROM.get(i * 4, limit);
+    EEPROM.get(16 + i, alarm);
+    if (limit < 30 || limit > 99 || alarm > 1)
+      return false;
+    bool box = i >= 2;
+    uint8_t index = box ? i - 2 : i;
+    if (index >= (box ? FILAMENT_BOX_COUNT : ZONE_COUNT))
+      continue;
+    uint8_t slot = box ? ZONE_COUNT + index : index;
+    legacy.humidityLimit[slot] = limit;
+    legacy.humidityAlarm[slot] = alarm;
   }
+  settings = legacy;
+  return true;
+}
 
-  // Timer check logic
-  if (enclosure1.useTimer && enclosure1.heaterOn)
+// Commit pending settings now, or once they have been quiet long enough.
+// Only calls that actually wrote to flash are timed.
+void commitSettings(bool now)
+{
+  uint32_t before = settingsStore.commits();
+  int64_t start = esp_timer_get_time();
+  if (now)
+    settingsStore.flush();
+  else
+    settingsStore.service(SETTINGS_QUIET_MS);
+  if (settingsStore.commits() != before)
+    eepromStats.recordSince(start);
+}
+
+void serviceSettings()
+{
+  commitSettings(false);
+}
+
+RunState captureRunState()
+{
+  RunState rs = {};
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
   {
-    unsigned long elapsed = (millis() - enclosure1.timerStart) / 1000UL;
-    unsigned long remaining = enclosure1.timerSeconds - elapsed;
-    if (remaining == 300 && !buzzerLocked)
-    { // 5 minutes left
-      digitalWrite(BUZZER_PIN, LOW);
-      delay(500);
-      digitalWrite(BUZZER_PIN, HIGH);
+    const Zone &z = zones[i];
+    ZoneRun &r = rs.zone[i];
+    bool heating = view.zone[i].heaterOn;
+    r.setpoint = view.zone[i].setpoint;
+    r.flags = (heating ? RUN_HEATING : 0) | (z.useTimer ? RUN_TIMER : 0);
+    r.timerSeconds = z.timerSeconds;
+    if (heating)
+      r.progress = z.useTimer ? timerRemaining(z) : (millis() - z.manualStart) / 1000UL;
+  }
+  return rs;
+}
+
+// Equal apart from progress, which only goes in at checkpoints
+bool sameRun(const RunState &a, const RunState &b)
+{
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    const ZoneRun &x = a.zone[i];
+    const ZoneRun &y = b.zone[i];
+    if (x.setpoint != y.setpoint || x.flags != y.flags || x.timerSeconds != y.timerSeconds)
+      return false;
+  }
+  return true;
+}
+
+// Journal the run state when it changes, and every JOURNAL_CHECKPOINT_MS
+// while a zone heats so a resumed timer loses at most that much progress
+// (it runs long rather than short). Only calls that wrote to flash are timed.
+void journalRunState()
+{
+  static unsigned long lastAppend = 0;
+  if (view.sampleMillis == 0)
+    return; // no snapshot from the control task yet
+  RunState now = captureRunState();
+  bool heating = false;
+  for (const ZoneRun &r : now.zone)
+    heating = heating || (r.flags & RUN_HEATING);
+  if (!sameRun(now, journalled) || (heating && millis() - lastAppend >= JOURNAL_CHECKPOINT_MS))
+  {
+    runJournal.append(now);
+    journalled = now;
+    lastAppend = millis();
+  }
+
+  uint32_t before = runJournal.commits();
+  int64_t start = esp_timer_get_time();
+  runJournal.service(JOURNAL_BATCH_MS);
+  if (runJournal.commits() != before)
+    eepromStats.recordSince(start);
+}
+
+// Pick up a job a reset interrupted: each zone's setpoint, whether it was
+// heating, and the time left on its timer or run. Called from setup()
+// before the control task starts, so it sets the zones directly.
+bool restoreRunState()
+{
+  RunState rs;
+  if (!runJournal.begin(rs))
+    return false;
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    Zone &z = zones[i];
+    const ZoneRun &r = rs.zone[i];
+    z.setpoint = r.setpoint;
+    z.targetTemp = r.setpoint / 10;
+    z.heaterOn = r.flags & RUN_HEATING;
+    z.timerSeconds = r.timerSeconds;
+    if (!z.heaterOn)
+      continue;
+    // A timer with nothing left cannot have been running (its expiry turns
+    // the zone off), so that heating run carries on as a manual one
+    if ((r.flags & RUN_TIMER) && r.progress > 0)
+      armZoneTimer(i, r.progress);
+    else
+      z.manualStart = millis() - (r.flags & RUN_TIMER ? 0 : r.progress * 1000UL);
+  }
+  journalled = rs;
+  return true;
+}
+
+void setup()
+{
+  Serial.setTxBufferSize(SERIAL_TX_BUFFER);
+  Serial.begin(115200);
+  EEPROM.begin(EEPROM_SIZE);
+  if (!settingsStore.begin() && migrateLegacySettings())
+  {
+    settingsStore.markDirty();
+    settingsStore.flush();
+  }
+  i2c.begin();
+  uint8_t sensorMask = 0;
+  for (const Zone &z : zones)
+    sensorMask |= 1 << z.muxChannel;
+  for (const FilamentBox &b : filamentBoxes)
+    sensorMask |= 1 << b.muxChannel;
+  sensors.begin(sensorMask);
+  for (uint8_t ch = 0; ch < SensorManager::CHANNELS; ch++)
+  {
+    if (sensors.enabled(ch) && !sensors.present(ch))
+    {
+      Serial.print("No Si7021 on mux channel ");
+      Serial.println(ch);
     }
-    if (remaining <= 30 && remaining > 0 && !buzzerLocked)
+  }
+  u8g2.setBusClock(I2cBus::CLOCK_HZ);
+  {
+    I2cBus::Guard guard(i2c);
+    u8g2.begin();
+  }
+
+  buzzer.begin();
+  inputQueue.begin(INPUT_QUEUE_LEN);
+  selectInput.begin();
+  backInput.begin();
+  encoder.onDetent(onEncoderDetent, nullptr);
+  encoder.attach();
+
+  for (const Zone &z : zones)
+  {
+    ledcSetup(z.ledcChannel, PWM_FREQ, PWM_RES);
+    ledcAttachPin(z.heaterPin, z.ledcChannel);
+  }
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    if (!zones[i].controller.configure(settings.gains[i]))
     {
-      for (int i = 0; i < 4; i++)
+      Serial.print("Stored PID gains rejected for zone ");
+      Serial.println(i + 1);
+      zones[i].controller.configure(DEFAULT_GAINS);
+    }
+  }
+
+  // Resume the journalled run; without one, zones come up heating in
+  // manual mode, as they always have
+  bool resumed = restoreRunState();
+  if (resumed)
+    Serial.printf("Run state restored (journal #%lu)\n", (unsigned long)runJournal.sequence());
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    if (!resumed)
+      zones[i].manualStart = millis();
+    if (zones[i].heaterOn)
+      scheduleRuntimeLimit(i);
+  }
+
+  scheduler.add(syncControlState, SNAPSHOT_INTERVAL_MS);
+  scheduler.add(handleInput, INPUT_INTERVAL_MS);
+  scheduler.add(checkTimers, TIMER_INTERVAL_MS);
+  scheduler.add(checkHumidityAlarms, HUMIDITY_INTERVAL_MS);
+  scheduler.add(recordHistory, HISTORY_SAMPLE_MS);
+  scheduler.add(serviceSettings, SETTINGS_INTERVAL_MS);
+  scheduler.add(journalRunState, JOURNAL_INTERVAL_MS);
+  scheduler.add(handleSerial, SERIAL_INTERVAL_MS);
+  scheduler.add(sendTelemetry, TELEMETRY_TICK_MS);
+#if ENABLE_NETWORK
+  scheduler.add(shareNetStatus, NET_STATUS_INTERVAL_MS);
+  scheduler.add(applyTimerCommands, NET_STATUS_INTERVAL_MS);
+#endif
+  scheduler.add(refreshDisplay, DISPLAY_INTERVAL_MS);
+
+  controlQueue = xQueueCreate(CONTROL_QUEUE_LEN, sizeof(ControlCommand));
+  xTaskCreatePinnedToCore(controlTask, "control", CONTROL_STACK, nullptr, CONTROL_PRIORITY, nullptr, CONTROL_CORE);
+#if ENABLE_NETWORK
+  timerQueue = xQueueCreate(TIMER_QUEUE_LEN, sizeof(TimerCommand));
+#endif
+  xTaskCreatePinnedToCore(uiTask, "ui", UI_STACK, nullptr, UI_PRIORITY, nullptr, UI_CORE);
+#if ENABLE_NETWORK
+  xTaskCreatePinnedToCore(networkTask, "net", NET_STACK, nullptr, NET_PRIORITY, nullptr, NET_CORE);
+#endif
+
+  lastInteraction = millis();
+  Serial.println("System initialized.");
+}
+
+// Run one channel's new reading, or the lack of one, through its filters.
+// Only an accepted temperature counts as fresh for the runaway detector.
+void filterChannel(uint8_t ch)
+{
+  const SensorManager::Sample &raw = sensors.sample(ch);
+  ChannelFilter &f = filters[ch];
+  if (raw.timestamp == f.rawMillis)
+  {
+    f.temp.miss(); // read failed, the sample is the previous one
+    f.humidity.miss();
+    return;
+  }
+  f.rawMillis = raw.timestamp;
+  if (f.temp.add(raw.temperature))
+    f.acceptedMillis = raw.timestamp;
+  f.humidity.add(raw.humidity);
+}
+
+// Collect a finished conversion batch and start the next one every
+// SAMPLE_INTERVAL_MS. The conversions run while control periods go by, and
+// controlStep() always works on the most recent filtered values.
+void sampleSensors()
+{
+  static unsigned long lastStart = 0;
+  if (sensors.collectCycle())
+  {
+    for (uint8_t ch = 0; ch < SensorManager::CHANNELS; ch++)
+    {
+      if (sensors.enabled(ch))
+        filterChannel(ch);
+    }
+    for (Zone &z : zones)
+    {
+      const ChannelFilter &f = filters[z.muxChannel];
+      z.currentTemp = f.temp.value();
+      z.humidity = f.humidity.value();
+      z.sampleMillis = f.acceptedMillis;
+    }
+    for (FilamentBox &b : filamentBoxes)
+    {
+      b.temp = filters[b.muxChannel].temp.value();
+      b.humidity = filters[b.muxChannel].humidity.value();
+    }
+  }
+  unsigned long now = millis();
+  if (now - lastStart >= SAMPLE_INTERVAL_MS && sensors.startCycle())
+    lastStart = now; // a start skipped on a busy bus is retried next period
+}
+
+// ledcWrite() always starts the pulse at counter 0; the power scheduler
+// needs the phase too. Arduino maps LEDC channels 0-7 to the high-speed
+// group, and each pair shares a timer, so the heaters' periods line up.
+void writeHeater(const Zone &z, uint8_t duty, uint16_t hpoint)
+{
+  ledc_set_duty_with_hpoint(LEDC_HIGH_SPEED_MODE, (ledc_channel_t)z.ledcChannel, duty, hpoint);
+  ledc_update_duty(LEDC_HIGH_SPEED_MODE, (ledc_channel_t)z.ledcChannel);
+}
+
+void heaterOff(Zone &z)
+{
+  z.controller.abortTune();
+  z.heaterOn = false;
+  z.duty = 0;
+  z.demand = 0;
+  writeHeater(z, 0, 0);
+}
+
+void controlStep()
+{
+  ScopedTimer timer(pidStats);
+
+  // Any zone over its limit shuts every heater down
+  bool overheat = false;
+  for (const Zone &z : zones)
+  {
+    if (z.currentTemp >= z.overheatLimit)
+      overheat = true;
+  }
+
+  // Nothing here may block, the UART included: syncControlState() logs
+  // the edge from the snapshot
+  if (overheat)
+  {
+    overheatActive = true;
+    for (Zone &z : zones)
+      heaterOff(z);
+  }
+  else
+  {
+    overheatActive = false;
+    unsigned long now = millis();
+    PowerScheduler<ZONE_COUNT>::Demand demand[ZONE_COUNT];
+    for (uint8_t i = 0; i < ZONE_COUNT; i++)
+    {
+      Zone &z = zones[i];
+      demand[i] = {0, 0, false};
+      // z.duty is still what the heater ran at over the last period
+      if (!z.heaterOn || z.runaway.step(z.currentTemp, z.sampleMillis, z.setpoint, z.duty, now))
+      {
+        heaterOff(z);
+        continue;
+      }
+      if (z.sampleMillis == 0)
+      {
+        // No accepted reading yet, so currentTemp is still 0 and the PID
+        // would ask for full power; stay on, but unpowered, until one lands
+        z.demand = 0;
+        continue;
+      }
+      z.demand = z.controller.step(z.setpoint, z.currentTemp, now);
+      demand[i] = {z.demand, (int16_t)(z.setpoint - z.currentTemp),
+                   z.controller.tuneState() == RelayAutoTune::RUNNING};
+    }
+
+    PowerScheduler<ZONE_COUNT>::Grant grant[ZONE_COUNT];
+    power.allocate(demand, grant);
+    for (uint8_t i = 0; i < ZONE_COUNT; i++)
+    {
+      Zone &z = zones[i];
+      if (!z.heaterOn)
+        continue;
+      z.duty = grant[i].duty;
+      writeHeater(z, grant[i].duty, grant[i].hpoint);
+    }
+  }
+}
+
+void applyControlCommands()
+{
+  ControlCommand cmd;
+  while (xQueueReceive(controlQueue, &cmd, 0) == pdTRUE)
+  {
+    if (cmd.zone >= ZONE_COUNT)
+      continue;
+    Zone &z = zones[cmd.zone];
+    switch (cmd.type)
+    {
+    case CMD_SET_SETPOINT:
+      z.setpoint = cmd.value;
+      break;
+    case CMD_HEATER_ON:
+      z.runaway.reset(millis());
+      if (!z.heaterOn)
+        z.controller.reset(); // a restart, not a timer re-armed while heating
+      z.heaterOn = true;
+      break;
+    case CMD_HEATER_OFF:
+      heaterOff(z);
+      break;
+    case CMD_ALL_OFF:
+      // Also the acknowledgement of a heater fault: every heater is off,
+      // so the latch can drop and the alarm and display stand down
+      for (Zone &other : zones)
       {
-        digitalWrite(BUZZER_PIN, LOW);
-        delay(150);
-        digitalWrite(BUZZER_PIN, HIGH);
-        delay(150);
+        heaterOff(other);
+        other.runaway.reset(millis());
       }
-      delay(500);
-      digitalWrite(BUZZER_PIN, LOW);
-      delay(1000);
-      digitalWrite(BUZZER_PIN, HIGH);
-      buzzerLocked = true;
+      break;
+    case CMD_SET_POWER_BUDGET:
+      power.setBudget(cmd.value);
+      break;
+    case CMD_AUTOTUNE:
+      z.runaway.reset(millis());
+      z.heaterOn = true;
+      z.controller.startTune(z.setpoint, millis());
+      break;
     }
-    if (elapsed >= enclosure1.timerSeconds)
+  }
+}
+
+void publishControlState()
+{
+  ControlSnapshot snap;
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    const Zone &z = zones[i];
+    ZoneStatus &st = snap.zone[i];
+    st.temp = z.currentTemp;
+    st.humidity = z.humidity;
+    st.setpoint = z.setpoint;
+    st.duty = z.duty;
+    st.demand = z.demand;
+    st.heaterOn = z.heaterOn;
+    st.gains = z.controller.gains();
+    st.tuneState = z.controller.tuneState();
+    st.tuneProgress = z.controller.tuneProgress();
+    st.fault = z.runaway.fault();
+    st.sensorHealth = filters[z.muxChannel].temp.health();
+  }
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++)
+  {
+    snap.filamentTemp[i] = filamentBoxes[i].temp;
+    snap.filamentHumidity[i] = filamentBoxes[i].humidity;
+    snap.filamentHealth[i] = filters[filamentBoxes[i].muxChannel].temp.health();
+  }
+  snap.overheat = overheatActive;
+  snap.sampleMillis = millis();
+  controlState.publish(snap);
+}
+
+// Everything the control task does in one period. The host simulation
+// (sim/) calls this directly on its virtual clock. The heaters are driven
+// from the last filtered sample before the bus is touched, so a sensor
+// pass waiting on an OLED flush can never hold back the control step.
+void controlPeriod()
+{
+  applyControlCommands();
+  controlStep();
+  sampleSensors();
+  publishControlState();
+}
+
+// High-priority control loop: sensors, PID, heater PWM and overheat cutoff,
+// woken every CONTROL_PERIOD_MS by vTaskDelayUntil. Never touches the
+// display, so a slow OLED transfer cannot delay it.
+void controlTask(void *)
+{
+  const int64_t periodUs = (int64_t)CONTROL_PERIOD_MS * 1000;
+  TickType_t lastWake = xTaskGetTickCount();
+  int64_t lastWakeUs = esp_timer_get_time();
+  for (Zone &z : zones)
+    z.runaway.reset(millis());
+  for (;;)
+  {
+    controlPeriod();
+
+    if (esp_timer_get_time() - lastWakeUs > periodUs)
+      controlOverruns++;
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(CONTROL_PERIOD_MS));
+    int64_t now = esp_timer_get_time();
+    int64_t error = (now - lastWakeUs) - periodUs;
+    jitterStats.record((uint32_t)(error < 0 ? -error : error));
+    lastWakeUs = now;
+  }
+}
+
+void sendControlCommand(ControlCommandType type, uint8_t zone, int32_t value)
+{
+  ControlCommand cmd = {type, zone, value};
+  xQueueSend(controlQueue, &cmd, 0);
+}
+
+// Zone whose heater the runaway detector has cut, or nullptr
+const Zone *faultedZone()
+{
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    if (view.zone[i].fault != RunawayDetector::FAULT_NONE)
+      return &zones[i];
+  }
+  return nullptr;
+}
+
+// Overheat or any zone fault: the runaway alarm and shutdown screen
+bool alarmActive()
+{
+  return view.overheat || faultedZone() != nullptr;
+}
+
+// UI side: pick up the latest control snapshot and react to alarm edges
+void syncControlState()
+{
+  bool wasAlarm = alarmActive();
+  bool wasOverheat = view.overheat;
+  uint8_t wasTuneState[ZONE_COUNT];
+  int16_t wasSetpoint[ZONE_COUNT];
+  uint8_t wasFault[ZONE_COUNT];
+  bool wasHeaterOn[ZONE_COUNT];
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    wasHeaterOn[i] = view.zone[i].heaterOn;
+    wasTuneState[i] = view.zone[i].tuneState;
+    wasSetpoint[i] = view.zone[i].setpoint;
+    wasFault[i] = view.zone[i].fault;
+  }
+  view = controlState.read();
+  if (view.overheat && !wasOverheat)
+    Serial.println("!! OVERHEAT DETECTED — SYSTEM SHUTDOWN !!");
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    // However a zone stopped (timer, cutoff, remote), its events are moot
+    if (wasHeaterOn[i] && !view.zone[i].heaterOn)
+      timerEvents.cancel(i);
+    // Follow setpoints changed by someone else (the network task)
+    if (view.zone[i].setpoint != wasSetpoint[i])
+      zones[i].targetTemp = view.zone[i].setpoint / 10;
+    if (view.zone[i].tuneState == RelayAutoTune::DONE && wasTuneState[i] != RelayAutoTune::DONE)
     {
-      enclosure1.heaterOn = false;
-      ledcWrite(HEATER1_CH, 0);
-      buzzerLocked = false;
+      // Persist the gains the control task actually loaded (post-clamping)
+      settings.gains[i] = view.zone[i].gains;
+      settingsStore.markDirty();
+      Serial.printf("Zone %d tuned: Kp=%.3f Ki=%.3f Kd=%.3f\n", i + 1,
+                    view.zone[i].gains.kp, view.zone[i].gains.ki, view.zone[i].gains.kd);
     }
+    if (view.zone[i].fault != RunawayDetector::FAULT_NONE && wasFault[i] == RunawayDetector::FAULT_NONE)
+      Serial.printf("!! %s HEATER FAULT: %s !!\n", zones[i].name, RunawayDetector::describe(view.zone[i].fault));
+    else if (view.zone[i].fault == RunawayDetector::FAULT_NONE && wasFault[i] != RunawayDetector::FAULT_NONE)
+      Serial.printf("%s heater fault cleared\n", zones[i].name);
+  }
+  bool alarm = alarmActive();
+  if (alarm && !wasAlarm)
+  {
+    alarmStart = millis();
+    buzzer.play(BUZZ_RUNAWAY);
+  }
+  else if (!alarm && wasAlarm)
+    buzzer.stop(BUZZ_RUNAWAY);
+}
+
+// Evaluate one humidity alarm; beeps and logs once per excursion
+void checkHumidity(const char *label, int16_t hum, int limit, bool enabled, bool &high)
+{
+  bool over = enabled && hum > limit * 10; // hum is in tenths
+  if (over && !high)
+  {
+    Serial.print("HIGH HUMIDITY: ");
+    Serial.println(label);
+    buzzer.play(BUZZ_HUMIDITY);
+  }
+  high = over;
+}
+
+// Runs from the scheduler regardless of which screen is open
+void checkHumidityAlarms()
+{
+  for (uint8_t slot = 0; slot < HUMIDITY_SLOTS; slot++)
+  {
+    checkHumidity(slotName(slot), slotHumidity(slot), settings.humidityLimit[slot], settings.humidityAlarm[slot], humidityHigh[slot]);
   }
+}
+
+// Encoder ISR: one event per detent, sized by how fast the knob turns
+void IRAM_ATTR onEncoderDetent(void *, int8_t direction)
+{
+  unsigned long now = millis();
+  int8_t delta = encoderAccel.step(direction, now);
+  inputQueue.postFromISR((delta == direction) ? INPUT_STEP : INPUT_FAST_STEP, delta, now);
+}
 
-  if (enclosure2.useTimer && enclosure2.heaterOn)
+void handleEvent(const InputEvent &e)
+{
+  const ScreenDesc &sc = SCREENS[screenIndex];
+  switch (e.type)
   {
-    unsigned long elapsed = (millis() - enclosure2.timerStart) / 1000UL;
-    unsigned long remaining = enclosure2.timerSeconds - elapsed;
-    if (remaining == 300 && !buzzerLocked)
+  case INPUT_STEP:
+  case INPUT_FAST_STEP:
+    if (sc.kind == SCREEN_KIND_EDITOR)
     {
-      digitalWrite(BUZZER_PIN, LOW);
-      delay(500);
-      digitalWrite(BUZZER_PIN, HIGH);
+      // Editors take the accelerated step and stop at either end of their
+      // range; the value is applied live (see applyEditor())
+      const ValueEditor &ed = *sc.editor;
+      cursorPos = constrain(cursorPos + e.delta, 0L, (long)ed.count - 1);
+      applyEditor(ed, editorValueAt(ed, cursorPos));
     }
-    if (remaining <= 30 && remaining > 0 && !buzzerLocked)
+    else if (sc.kind == SCREEN_KIND_MENU)
+      cursorPos = wrapIndex(cursorPos + (e.delta > 0 ? 1 : -1), sc.itemCount); // one row per detent
+    break;
+  case INPUT_CLICK:
+    if (sc.kind == SCREEN_KIND_MENU)
     {
-      for (int i = 0; i < 4; i++)
+      const MenuItem &item = sc.items[wrapIndex(cursorPos, sc.itemCount)];
+      if (item.kind == ITEM_SCREEN)
       {
-        digitalWrite(BUZZER_PIN, LOW);
-        delay(150);
-        digitalWrite(BUZZER_PIN, HIGH);
-        delay(150);
+        if (item.slot != SLOT_ACTIVE)
+          activeSlot = item.slot;
+        enterScreen(item.target);
       }
-      delay(500);
-      digitalWrite(BUZZER_PIN, LOW);
-      delay(1000);
-      digitalWrite(BUZZER_PIN, HIGH);
-      buzzerLocked = true;
+      else
+        runAction(item.target, resolveSlot(item.slot));
     }
-    if (elapsed >= enclosure2.timerSeconds)
+    else if (sc.kind == SCREEN_KIND_EDITOR)
+      confirmEditor(*sc.editor);
+    break;
+  case INPUT_LONG_PRESS:
+    enterScreen(SCREEN_MAIN);
+    break;
+  case INPUT_BACK:
+    enterScreen(sc.parent);
+    break;
+  default:
+    break;
+  }
+}
+
+// Consume the input queue. Any event counts as interaction; one that
+// arrives while the screen is idle or asleep only wakes it.
+void handleInput()
+{
+  InputEvent e;
+  while (inputQueue.next(e))
+  {
+    if ((e.type == INPUT_CLICK || e.type == INPUT_LONG_PRESS) && settings.beepOnPush)
+      buzzer.play(BUZZ_CLICK);
+    if (!wakeDisplay())
+      handleEvent(e);
+  }
+}
+
+// The current menu screen, or a zone held up by "View Temp"
+void renderScreen()
+{
+  if (heldZone)
+  {
+    if ((long)(millis() - heldZoneUntil) < 0)
     {
-      enclosure2.heaterOn = false;
-      ledcWrite(HEATER2_CH, 0);
-      buzzerLocked = false;
+      displayZone(*heldZone);
+      return;
     }
+    heldZone = nullptr;
   }
 
-  updateScreen();
-  delay(500);
+  const ScreenDesc &sc = SCREENS[screenIndex];
+  switch (sc.kind)
+  {
+  case SCREEN_KIND_MENU:
+    renderMenu(sc);
+    break;
+  case SCREEN_KIND_EDITOR:
+    renderEditor(sc);
+    break;
+  case SCREEN_KIND_VIEW:
+    sc.render(resolveSlot(sc.slot));
+    break;
+  }
+}
+
+// One frame: the buffer is cleared and the regular font selected here,
+// once, and the result flushed after whichever renderer applies
+void refreshDisplay()
+{
+  if (!updateScreen())
+    return;
+
+  u8g2.clearBuffer();
+  u8g2.setFont(u8g2_font_ncenB08_tr);
+  if (view.overheat)
+  {
+    // Flash the shutdown notice (500 ms on, 300 ms off) while overheated
+    if ((millis() - alarmStart) % 800 < 500)
+    {
+      u8g2.drawStr(0, 24, "!!! OVERHEAT !!!");
+      u8g2.drawStr(0, 44, "SYSTEM SHUTDOWN");
+    }
+  }
+  else if (displayState == DISPLAY_IDLE)
+    renderIdle();
+  else
+    renderScreen();
+  oled.flush();
+}
+
+// Fold the latest readings into the open history buckets and seal them
+// every HISTORY_BUCKET_MS
+void recordHistory()
+{
+  static unsigned long bucketStart = millis();
+  if (view.sampleMillis == 0)
+    return; // no snapshot from the control task yet
+  for (uint8_t slot = 0; slot < HUMIDITY_SLOTS; slot++)
+    history[slot].add(slotTemp(slot), slotHumidity(slot));
+  if (millis() - bucketStart >= HISTORY_BUCKET_MS)
+  {
+    bucketStart += HISTORY_BUCKET_MS;
+    for (uint8_t slot = 0; slot < HUMIDITY_SLOTS; slot++)
+      history[slot].close();
+  }
+}
+
+// Run a zone's full timer from now, and (re)start its heater
+void startZoneTimer(uint8_t zone)
+{
+  armZoneTimer(zone, zones[zone].timerSeconds);
+  sendControlCommand(CMD_HEATER_ON, zone, 0);
+}
+
+// Arm a zone's timer to end remainingSeconds from now: the 5-minute and
+// 30-second warnings and the expiry each become one event
+void armZoneTimer(uint8_t zone, unsigned long remainingSeconds)
+{
+  Zone &z = zones[zone];
+  unsigned long end = millis() + remainingSeconds * 1000UL;
+  z.useTimer = true;
+  z.pendingTimerMode = false;
+  z.timerStart = end - z.timerSeconds * 1000UL;
+  timerEvents.cancel(zone);
+  if (remainingSeconds > 300)
+    timerEvents.schedule(end - 300000UL, zone, TIMER_FIVE_MIN);
+  if (remainingSeconds > 30)
+    timerEvents.schedule(end - 30000UL, zone, TIMER_COUNTDOWN);
+  timerEvents.schedule(end, zone, TIMER_EXPIRED);
+}
+
+// Heat until stopped, or until the runtime limit with auto-off enabled
+void startZoneManual(uint8_t zone)
+{
+  Zone &z = zones[zone];
+  z.useTimer = false;
+  z.pendingTimerMode = false;
+  z.manualStart = millis();
+  timerEvents.cancel(zone);
+  scheduleRuntimeLimit(zone);
+  sendControlCommand(CMD_HEATER_ON, zone, 0);
+}
+
+// (Re)arm or drop the MAX_MANUAL_RUNTIME_SECONDS auto-off of a manual run,
+// counted from when the run began
+void scheduleRuntimeLimit(uint8_t zone)
+{
+  const Zone &z = zones[zone];
+  timerEvents.cancel(zone, TIMER_RUNTIME_LIMIT);
+  if (settings.autoShutoffEnabled && !z.useTimer)
+    timerEvents.schedule(z.manualStart + MAX_MANUAL_RUNTIME_SECONDS * 1000UL, zone, TIMER_RUNTIME_LIMIT);
+}
+
+// Fire whatever timer events are due. Between events this is a single
+// comparison against the earliest deadline.
+void checkTimers()
+{
+  TimerEvents::Event e;
+  while (timerEvents.pop(millis(), e))
+  {
+    switch (e.type)
+    {
+    case TIMER_FIVE_MIN:
+      buzzer.play(BUZZ_FIVE_MIN);
+      break;
+    case TIMER_COUNTDOWN:
+      buzzer.play(BUZZ_TIMER_END);
+      break;
+    case TIMER_EXPIRED:
+      sendControlCommand(CMD_HEATER_OFF, e.owner, 0);
+      break;
+    case TIMER_RUNTIME_LIMIT:
+      Serial.printf("%s: auto-off after %d h\n", zones[e.owner].name, MAX_MANUAL_RUNTIME_SECONDS / 3600);
+      sendControlCommand(CMD_HEATER_OFF, e.owner, 0);
+      break;
+    }
+  }
+}
+
+void printStats()
+{
+  char label[16];
+  for (uint8_t ch = 0; ch < SensorManager::CHANNELS; ch++)
+  {
+    if (!sensors.enabled(ch))
+      continue;
+    snprintf(label, sizeof(label), "sensor ch%u", ch);
+    sensors.readLatency(ch).print(Serial, label);
+    Serial.printf("             i2c errors=%lu health=%u%% outliers=%lu\n", (unsigned long)sensors.errors(ch),
+                  filters[ch].temp.health(), (unsigned long)(filters[ch].temp.outliers() + filters[ch].humidity.outliers()));
+  }
+  Serial.printf("i2c bus      mux switches=%lu recoveries=%lu busy skips=%lu\n", (unsigned long)i2c.switches(),
+                (unsigned long)i2c.recoveries(), (unsigned long)sensors.busySkips());
+  pidStats.print(Serial, "pid step");
+  jitterStats.print(Serial, "ctl jitter");
+  Serial.printf("             overruns=%lu\n", (unsigned long)controlOverruns);
+  Serial.printf("power        budget=%u limited periods=%lu\n", power.budget(), (unsigned long)power.limitedPeriods());
+  oled.flushLatency().print(Serial, "oled flush");
+  Serial.printf("             rows sent=%lu frames skipped=%lu\n",
+                (unsigned long)oled.rowsSent(), (unsigned long)oled.framesSkipped());
+  eepromStats.print(Serial, "eeprom");
+  Serial.printf("             settings commits=%lu journal commits=%lu\n", (unsigned long)settingsStore.commits(),
+                (unsigned long)runJournal.commits());
+  buzzer.stepLatency().print(Serial, "buzzer");
+  Serial.printf("input        events dropped=%lu\n", (unsigned long)inputQueue.dropped());
+  Serial.printf("telemetry    sent=%lu dropped=%lu\n", (unsigned long)telemetry.sent(),
+                (unsigned long)(telemetry.dropped() + telemetryTextDropped));
+#if ENABLE_NETWORK
+  Serial.printf("mqtt         connected=%d reconnects=%lu\n", mqtt.connected(), (unsigned long)mqtt.reconnects());
+#endif
+}
+
+// Budget between nothing and every heater fully on
+void setPowerBudget(long counts)
+{
+  long most = (long)PowerScheduler<ZONE_COUNT>::PERIOD * ZONE_COUNT;
+  sendControlCommand(CMD_SET_POWER_BUDGET, 0, constrain(counts, 0L, most));
+}
+
+void resetStats()
+{
+  sensors.resetStats();
+  for (ChannelFilter &f : filters)
+  {
+    f.temp.resetStats();
+    f.humidity.resetStats();
+  }
+  i2c.resetStats();
+  oled.resetStats();
+  pidStats.reset();
+  jitterStats.reset();
+  controlOverruns = 0;
+  power.resetStats();
+  eepromStats.reset();
+  buzzer.resetStats();
+  telemetry.resetStats();
+  telemetryTextDropped = 0;
+  inputQueue.resetStats();
+}
+
+volatile int32_t benchSink; // keeps benchmark results alive through the optimiser
+
+// Cycle counts of the hot paths for the "bench" command, best and mean of
+// `runs` calls. Only calls for which `op` returns true are counted.
+template <typename Op>
+void benchCycles(const char *name, uint16_t runs, Op op)
+{
+  uint32_t best = UINT32_MAX;
+  uint64_t total = 0;
+  uint16_t counted = 0;
+  for (uint16_t i = 0; i < runs; i++)
+  {
+    uint32_t start = ESP.getCycleCount();
+    bool ok = op(i);
+    uint32_t cycles = ESP.getCycleCount() - start;
+    if (!ok)
+      continue;
+    best = min(best, cycles);
+    total += cycles;
+    counted++;
+  }
+  if (counted == 0)
+  {
+    Serial.printf("%-14s not measured\n", name);
+    return;
+  }
+  uint32_t mean = total / counted;
+  Serial.printf("%-14s best=%lu mean=%lu cycles (%lu us) n=%u\n", name, (unsigned long)best, (unsigned long)mean,
+                (unsigned long)(mean / getCpuFrequencyMhz()), counted);
+}
+
+// Runs on the UI task. The control-side stages are timed on scratch
+// objects so the live zones are untouched; the sensor read and the frame
+// flush use the real bus and hold it like any other transaction.
+void runBenchmarks()
+{
+  benchCycles("encoder tick", 1000, [](uint16_t) {
+    benchEncoder.tick();
+    return true;
+  });
+
+  SensorFilter filter(-400, 2570, 50);
+  benchCycles("filter add", 1000, [&filter](uint16_t i) {
+    filter.add(720 + (i & 3));
+    benchSink = filter.value();
+    return true;
+  });
+
+  static HeaterController controller(CONTROL_HZ); // FastPID state is large for the UI stack
+  controller.configure(DEFAULT_GAINS);
+  benchCycles("pid step", 1000, [](uint16_t i) {
+    benchSink = controller.step(900, 850 + (i & 15), i * CONTROL_PERIOD_MS);
+    return true;
+  });
+
+  PowerScheduler<ZONE_COUNT> budget(HEATER_POWER_BUDGET);
+  benchCycles("power allocate", 1000, [&budget](uint16_t i) {
+    PowerScheduler<ZONE_COUNT>::Demand demand[ZONE_COUNT];
+    PowerScheduler<ZONE_COUNT>::Grant grant[ZONE_COUNT];
+    for (uint8_t z = 0; z < ZONE_COUNT; z++)
+      demand[z] = {(uint8_t)(200 - z * 40), (int16_t)(z * 10 + (i & 7)), false};
+    budget.allocate(demand, grant);
+    benchSink = grant[0].duty;
+    return true;
+  });
+
+  // Between cycles only, so several calls fail and are retried later
+  benchCycles("sensor read", 200, [](uint16_t i) {
+    int16_t temp = 0;
+    bool ok = sensors.readTemperature(zones[i % ZONE_COUNT].muxChannel, temp);
+    benchSink = temp;
+    if (!ok)
+      vTaskDelay(1);
+    return ok;
+  });
+
+  benchCycles("frame render", 50, [](uint16_t) {
+    u8g2.clearBuffer();
+    u8g2.setFont(u8g2_font_ncenB08_tr);
+    renderScreen();
+    return true;
+  });
+
+  benchCycles("frame flush", 5, [](uint16_t) {
+    oled.invalidate(); // send every row, as after a wake
+    oled.flush();
+    return true;
+  });
+  frameRequested = true; // put the real frame back
+}
+
+// Console commands:
+//   stats / stats reset             stage timings (see printStats())
+//   telemetry off|binary|text       select the telemetry stream
+//   telemetry rate <ms>             telemetry record interval
+//   power <counts>                  combined heater budget, see HEATER_POWER_BUDGET
+//   bench                           cycle counts of the hot paths, see runBenchmarks()
+// The control task's histograms may take one more sample while being
+// cleared, which only skews the next dump.
+void runCommand(const char *line)
+{
+  if (strcmp(line, "stats") == 0)
+    printStats();
+  else if (strcmp(line, "stats reset") == 0)
+  {
+    resetStats();
+    Serial.println("Stats cleared.");
+  }
+  else if (strcmp(line, "telemetry off") == 0)
+    telemetryMode = TELEMETRY_OFF;
+  else if (strcmp(line, "telemetry binary") == 0)
+    telemetryMode = TELEMETRY_BINARY;
+  else if (strcmp(line, "telemetry text") == 0)
+    telemetryMode = TELEMETRY_TEXT;
+  else if (strncmp(line, "telemetry rate ", 15) == 0)
+  {
+    long ms = atol(line + 15);
+    if (ms >= TELEMETRY_TICK_MS)
+      telemetryIntervalMs = ms;
+  }
+  else if (strncmp(line, "power ", 6) == 0)
+    setPowerBudget(atol(line + 6));
+  else if (strcmp(line, "bench") == 0)
+    runBenchmarks();
+  else if (line[0] != '\0')
+    Serial.println("Commands: stats, stats reset, telemetry off|binary|text, telemetry rate <ms>, power <counts>, bench");
+}
+
+// Line-based serial console, see runCommand()
+void handleSerial()
+{
+  while (Serial.available() > 0)
+  {
+    char c = (char)Serial.read();
+    if (c != '\n' && c != '\r')
+    {
+      if (serialLineLen < SERIAL_LINE_MAX - 1)
+        serialLine[serialLineLen++] = c;
+      continue;
+    }
+    serialLine[serialLineLen] = '\0';
+    runCommand(serialLine);
+    serialLineLen = 0;
+  }
+}
+
+void fillTelemetry(TelemetryRecord &rec)
+{
+  rec.type = TelemetryRecord::STATUS;
+  rec.zoneCount = ZONE_COUNT;
+  rec.boxCount = FILAMENT_BOX_COUNT;
+  rec.flags = view.overheat ? TelemetryRecord::FLAG_OVERHEAT : 0;
+  rec.sequence = 0;
+  rec.millis = millis();
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    const ZoneStatus &st = view.zone[i];
+    TelemetryZone &t = rec.zone[i];
+    bool timed = zones[i].useTimer && st.heaterOn;
+    t.temp = st.temp;
+    t.humidity = st.humidity;
+    t.setpoint = st.setpoint;
+    t.duty = st.duty;
+    t.demand = st.demand;
+    t.health = st.sensorHealth;
+    t.flags = (st.heaterOn ? TelemetryRecord::FLAG_HEATER : 0) | (timed ? TelemetryRecord::FLAG_TIMER : 0) |
+              (humidityHigh[i] ? TelemetryRecord::FLAG_HUMIDITY : 0) |
+              (st.tuneState == RelayAutoTune::RUNNING ? TelemetryRecord::FLAG_TUNING : 0) |
+              (st.fault != RunawayDetector::FAULT_NONE ? TelemetryRecord::FLAG_FAULT : 0);
+    t.timerRemaining = timed ? timerRemaining(zones[i]) : 0;
+  }
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++)
+  {
+    rec.box[i].temp = view.filamentTemp[i];
+    rec.box[i].humidity = view.filamentHumidity[i];
+    rec.box[i].health = view.filamentHealth[i];
+    rec.box[i].flags = humidityHigh[ZONE_COUNT + i] ? TelemetryRecord::FLAG_HUMIDITY : 0;
+  }
+}
+
+// Human-readable fallback: one "key=value" line per record, dropped like a
+// binary frame if the TX buffer cannot take it whole
+void sendTelemetryText(const TelemetryRecord &rec)
+{
+  char line[64 + 48 * (ZONE_COUNT + FILAMENT_BOX_COUNT)];
+  int n = snprintf(line, sizeof(line), "T seq=%lu ms=%lu oh=%u", (unsigned long)rec.sequence,
+                   (unsigned long)rec.millis, rec.flags & TelemetryRecord::FLAG_OVERHEAT);
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    const TelemetryZone &t = rec.zone[i];
+    n += snprintf(line + n, sizeof(line) - n, " z%u=%d.%d,%d.%d,%d.%d,%u,%02x,%lu", i, t.temp / 10, abs(t.temp % 10),
+                  t.setpoint / 10, abs(t.setpoint % 10), t.humidity / 10, t.humidity % 10, t.duty, t.flags,
+                  (unsigned long)t.timerRemaining);
+  }
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++)
+  {
+    const TelemetryBox &b = rec.box[i];
+    n += snprintf(line + n, sizeof(line) - n, " b%u=%d.%d,%d.%d,%02x", i, b.temp / 10, abs(b.temp % 10),
+                  b.humidity / 10, b.humidity % 10, b.flags);
+  }
+  n += snprintf(line + n, sizeof(line) - n, "\n");
+  if (Serial.availableForWrite() < n)
+  {
+    telemetryTextDropped++;
+    return;
+  }
+  Serial.write((const uint8_t *)line, n);
+}
+
+// Periodic status record on the console port, see TelemetryWriter
+void sendTelemetry()
+{
+  static unsigned long lastSent = 0;
+  if (telemetryMode == TELEMETRY_OFF || millis() - lastSent < telemetryIntervalMs)
+    return;
+  lastSent = millis();
+
+  TelemetryRecord rec;
+  fillTelemetry(rec);
+  rec.sequence = telemetrySequence++;
+  if (telemetryMode == TELEMETRY_BINARY)
+    telemetry.send(&rec, sizeof(rec));
+  else
+    sendTelemetryText(rec);
+}
+
+#if ENABLE_NETWORK
+// UI side: hand the network task a consistent copy of the status record
+void shareNetStatus()
+{
+  TelemetryRecord rec;
+  fillTelemetry(rec);
+  netStatus.publish(rec);
+}
+
+// UI side: timers requested over MQTT
+void applyTimerCommands()
+{
+  TimerCommand cmd;
+  while (xQueueReceive(timerQueue, &cmd, 0) == pdTRUE)
+  {
+    if (cmd.zone >= ZONE_COUNT)
+      continue;
+    if (cmd.seconds > 0)
+    {
+      zones[cmd.zone].timerSeconds = cmd.seconds;
+      startZoneTimer(cmd.zone);
+    }
+    else
+      startZoneManual(cmd.zone);
+  }
+}
+
+int32_t editorMax(const ValueEditor &ed)
+{
+  return ed.minValue + (int32_t)(ed.count - 1) * ed.step;
+}
+
+// Network task: MQTT commands under <base>/cmd/, zones numbered from 1.
+// Heater changes go straight onto controlQueue and timers onto timerQueue;
+// a full queue drops the command instead of waiting, and nothing here
+// touches UI or control state directly.
+//   cmd/zone/<n>/setpoint  degrees F, clamped to the menu's range
+//   cmd/zone/<n>/timer     seconds, 0 = manual mode
+//   cmd/zone/<n>/off
+//   cmd/alloff
+//   cmd/power              combined heater budget in LEDC counts
+//   cmd/interval           state publish interval in ms
+void handleRemoteCommand(const char *sub, const char *payload)
+{
+  long value = atol(payload);
+  if (strcmp(sub, "cmd/alloff") == 0)
+  {
+    sendControlCommand(CMD_ALL_OFF, 0, 0);
+    return;
+  }
+  if (strcmp(sub, "cmd/power") == 0)
+  {
+    setPowerBudget(value);
+    return;
+  }
+  if (strcmp(sub, "cmd/interval") == 0)
+  {
+    if (value >= NET_PUBLISH_MIN_MS)
+      netPublishMs = value;
+    return;
+  }
+
+  unsigned zone;
+  char action[12];
+  if (sscanf(sub, "cmd/zone/%u/%11s", &zone, action) != 2 || zone < 1 || zone > ZONE_COUNT)
+    return;
+  uint8_t i = zone - 1;
+  if (strcmp(action, "setpoint") == 0)
+  {
+    value = constrain(value, (long)TEMP_EDITOR.minValue, (long)editorMax(TEMP_EDITOR));
+    sendControlCommand(CMD_SET_SETPOINT, i, value * 10);
+  }
+  else if (strcmp(action, "timer") == 0)
+  {
+    if (value > 0)
+      value = constrain(value, (long)TIMER_EDITOR.minValue, (long)editorMax(TIMER_EDITOR));
+    TimerCommand cmd = {i, value > 0 ? (uint32_t)value : 0};
+    xQueueSend(timerQueue, &cmd, 0);
+  }
+  else if (strcmp(action, "off") == 0)
+    sendControlCommand(CMD_HEATER_OFF, i, 0);
+}
+
+// One bit per alarm that should be published without waiting for the
+// next interval: overheat, humidity per slot, then heater faults
+uint32_t alarmBits(const TelemetryRecord &rec)
+{
+  uint32_t bits = (rec.flags & TelemetryRecord::FLAG_OVERHEAT) ? 1 : 0;
+  for (uint8_t i = 0; i < ZONE_COUNT; i++)
+  {
+    if (rec.zone[i].flags & TelemetryRecord::FLAG_HUMIDITY)
+      bits |= 2UL << i;
+    if (rec.zone[i].flags & TelemetryRecord::FLAG_FAULT)
+      bits |= 2UL << (HUMIDITY_SLOTS + i);
+  }
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT; i++)
+  {
+    if (rec.box[i].flags & TelemetryRecord::FLAG_HUMIDITY)
+      bits |= 2UL << (ZONE_COUNT + i);
+  }
+  return bits;
+}
+
+// All zones and boxes batched into one JSON document
+size_t formatNetState(const TelemetryRecord &rec, char *buf, size_t size)
+{
+  size_t n = snprintf(buf, size, "{\"uptime\":%lu,\"overheat\":%s,\"zones\":[", (unsigned long)(rec.millis / 1000),
+                      (rec.flags & TelemetryRecord::FLAG_OVERHEAT) ? "true" : "false");
+  for (uint8_t i = 0; i < ZONE_COUNT && n < size; i++)
+  {
+    const TelemetryZone &t = rec.zone[i];
+    n += snprintf(buf + n, size - n,
+                  "%s{\"name\":\"%s\",\"temp\":%d.%d,\"setpoint\":%d.%d,\"humidity\":%d.%d,\"duty\":%u,\"demand\":%u,\"sensorHealth\":%u,"
+                  "\"heater\":%s,\"timer\":%lu,\"tuning\":%s,\"fault\":%s,\"humidityHigh\":%s}",
+                  i ? "," : "", zones[i].name, t.temp / 10, abs(t.temp % 10), t.setpoint / 10, abs(t.setpoint % 10),
+                  t.humidity / 10, t.humidity % 10, t.duty, t.demand, t.health,
+                  (t.flags & TelemetryRecord::FLAG_HEATER) ? "true" : "false", (unsigned long)t.timerRemaining,
+                  (t.flags & TelemetryRecord::FLAG_TUNING) ? "true" : "false",
+                  (t.flags & TelemetryRecord::FLAG_FAULT) ? "true" : "false",
+                  (t.flags & TelemetryRecord::FLAG_HUMIDITY) ? "true" : "false");
+  }
+  if (n < size)
+    n += snprintf(buf + n, size - n, "],\"boxes\":[");
+  for (uint8_t i = 0; i < FILAMENT_BOX_COUNT && n < size; i++)
+  {
+    const TelemetryBox &b = rec.box[i];
+    n += snprintf(buf + n, size - n, "%s{\"name\":\"%s\",\"temp\":%d.%d,\"humidity\":%d.%d,\"sensorHealth\":%u,\"humidityHigh\":%s}",
+                  i ? "," : "", filamentBoxes[i].name, b.temp / 10, abs(b.temp % 10), b.humidity / 10,
+                  b.humidity % 10, b.health, (b.flags & TelemetryRecord::FLAG_HUMIDITY) ? "true" : "false");
+  }
+  if (n < size)
+    n += snprintf(buf + n, size - n, "]}");
+  return n < size ? n : 0;
+}
+
+// Wi-Fi, MQTT and their reconnects, on the UI core at the UI's priority.
+// Publishes the retained <base>/state every netPublishMs, or early (but no
+// faster than NET_PUBLISH_MIN_MS) when an alarm changes. Blocking here
+// stalls only this task.
+void networkTask(void *)
+{
+  static char payload[MqttLink::BUFFER_SIZE - MqttLink::TOPIC_MAX - 8];
+  unsigned long lastPublish = 0;
+  uint32_t lastAlarms = 0;
+  bool published = false;
+  mqtt.begin(WIFI_SSID, WIFI_PASSWORD, MQTT_HOST, MQTT_PORT, MQTT_BASE_TOPIC, handleRemoteCommand);
+  for (;;)
+  {
+    unsigned long now = millis();
+    mqtt.service(now);
+
+    TelemetryRecord rec = netStatus.read();
+    uint32_t alarms = alarmBits(rec);
+    bool due = !published || now - lastPublish >= netPublishMs;
+    bool alarmChanged = alarms != lastAlarms && now - lastPublish >= NET_PUBLISH_MIN_MS;
+    if (rec.millis != 0 && mqtt.connected() && (due || alarmChanged) &&
+        formatNetState(rec, payload, sizeof(payload)) > 0 && mqtt.publish("state", payload, true))
+    {
+      lastPublish = now;
+      lastAlarms = alarms;
+      published = true;
+    }
+    vTaskDelay(pdMS_TO_TICKS(NET_POLL_MS));
+  }
+}
+#endif
+
+// Menus, display, buzzer and EEPROM writes, on the other core from control
+void uiTask(void *)
+{
+  for (;;)
+  {
+    scheduler.run();
+    vTaskDelay(1);
+  }
+}
+
+void loop()
+{
+  // Everything runs in controlTask/uiTask; the Arduino loop task is not needed
+  vTaskDelete(NULL);
 }
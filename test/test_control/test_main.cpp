@@ -0,0 +1,177 @@
+// The control pipeline between a raw reading and the heater duty:
+// SensorFilter's rejection and smoothing, then HeaterController, including
+// a relay tune run against the sim's enclosure model.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "SensorFilter.h"
+#include "HeaterController.h"
+#include "ThermalModel.h"
+
+namespace {
+
+const PidGains GAINS = {2.0f, 5.0f, 1.0f}; // main.cpp's DEFAULT_GAINS
+const uint16_t HZ = 10;
+
+// Temperature channel as configured in main.cpp
+SensorFilter tempFilter() {
+    return SensorFilter(-400, 2570, 50);
+}
+
+void feed(SensorFilter &f, int16_t raw, uint8_t times) {
+    for (uint8_t i = 0; i < times; i++) f.add(raw);
+}
+
+// Run the PID `steps` periods against a fixed temperature
+uint8_t hold(HeaterController &c, int16_t setpoint, int16_t temp, uint32_t steps) {
+    uint8_t duty = 0;
+    for (uint32_t i = 0; i < steps; i++) duty = c.step(setpoint, temp, i * (1000 / HZ));
+    return duty;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_filter_seeds_on_the_first_reading() {
+    SensorFilter f = tempFilter();
+    TEST_ASSERT_FALSE(f.valid());
+    TEST_ASSERT_TRUE(f.add(725));
+    TEST_ASSERT_TRUE(f.valid());
+    TEST_ASSERT_EQUAL(725, f.value());
+}
+
+void test_filter_drops_out_of_range_codes() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 10);
+    uint8_t health = f.health();
+    TEST_ASSERT_FALSE(f.add(3000));
+    TEST_ASSERT_FALSE(f.add(-500));
+    TEST_ASSERT_EQUAL(700, f.value());
+    TEST_ASSERT_LESS_THAN(health, f.health());
+}
+
+void test_filter_holds_back_a_single_spike() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 10);
+    TEST_ASSERT_FALSE(f.add(900));
+    TEST_ASSERT_EQUAL(700, f.value());
+    TEST_ASSERT_TRUE(f.add(700));
+    TEST_ASSERT_EQUAL(1, f.outliers());
+}
+
+void test_filter_follows_a_persistent_jump() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 10);
+    for (uint8_t i = 1; i < SensorFilter::REJECT_LIMIT; i++) TEST_ASSERT_FALSE(f.add(900));
+    TEST_ASSERT_TRUE(f.add(900)); // re-seeded at the new level
+    TEST_ASSERT_EQUAL(900, f.value());
+}
+
+void test_filter_median_ignores_one_odd_sample() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 10);
+    f.add(740); // inside maxStep, so accepted, but outvoted by the median
+    TEST_ASSERT_EQUAL(700, f.value());
+}
+
+void test_filter_converges_on_a_small_step() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 10);
+    feed(f, 730, 20);
+    TEST_ASSERT_INT_WITHIN(1, 730, f.value());
+}
+
+void test_filter_health_tracks_misses() {
+    SensorFilter f = tempFilter();
+    feed(f, 700, 60);
+    TEST_ASSERT_EQUAL(100, f.health());
+    for (uint8_t i = 0; i < 60; i++) f.miss();
+    TEST_ASSERT_EQUAL(0, f.health());
+}
+
+void test_pid_output_saturates_both_ways() {
+    HeaterController c(HZ);
+    TEST_ASSERT_TRUE(c.configure(GAINS));
+    TEST_ASSERT_EQUAL(HeaterController::DUTY_MAX, hold(c, 900, 500, 20));
+    c.reset();
+    TEST_ASSERT_EQUAL(0, hold(c, 900, 1100, 20));
+}
+
+// Conditional integration: however long the output sits at full power,
+// the integral stops where saturation began, so it comes off full power
+// as soon as the temperature crosses the setpoint
+void test_pid_integral_does_not_wind_up() {
+    HeaterController brief(HZ);
+    HeaterController warmup(HZ);
+    brief.configure(GAINS);
+    warmup.configure(GAINS);
+    hold(brief, 900, 600, 100);           // 10 s at full power
+    hold(warmup, 900, 600, 10UL * 36000); // 10 h
+    uint8_t after = hold(brief, 900, 905, 1);
+    TEST_ASSERT_EQUAL(after, hold(warmup, 900, 905, 1));
+    TEST_ASSERT_LESS_THAN(HeaterController::DUTY_MAX, after);
+}
+
+void test_pid_integral_holds_a_steady_duty() {
+    HeaterController c(HZ);
+    c.configure(GAINS);
+    hold(c, 900, 895, 600); // a minute half a degree low
+    TEST_ASSERT_GREATER_THAN(0, hold(c, 900, 900, 10));
+}
+
+void test_pid_reset_clears_the_integral() {
+    HeaterController c(HZ);
+    c.configure(GAINS);
+    hold(c, 900, 895, 600);
+    c.reset();
+    hold(c, 900, 900, 1); // first step after a reset only re-primes the derivative
+    TEST_ASSERT_EQUAL(0, hold(c, 900, 900, 1));
+}
+
+void test_tiny_gains_still_load() {
+    HeaterController c(HZ);
+    const PidGains tiny = {0.001f, 0.0001f, 0.0001f};
+    TEST_ASSERT_TRUE(c.configure(tiny));
+    TEST_ASSERT_GREATER_THAN(0, (int)(c.gains().kp * 1000000));
+}
+
+// A tune on the default enclosure model must hand back different gains,
+// and the large Kd a slow enclosure tunes to must survive unclamped
+void test_completed_tune_changes_the_gains() {
+    const float ambient = 22.2f;
+    ThermalZone zone;
+    zone.reset(ambient);
+    HeaterController c(HZ);
+    c.configure(GAINS);
+    c.startTune(1000, 0);
+    unsigned long now = 0;
+    for (; now < RelayAutoTune::TIMEOUT_MS && c.tuneState() == RelayAutoTune::RUNNING; now += 1000 / HZ) {
+        int16_t temp = (int16_t)lrintf(toFahrenheit(zone.sensed()) * 10);
+        uint8_t duty = c.step(1000, temp, now);
+        zone.step(duty / (float)HeaterController::DUTY_MAX, ambient, 1.0f / HZ);
+    }
+    TEST_ASSERT_EQUAL(RelayAutoTune::DONE, c.tuneState());
+    TEST_ASSERT_TRUE(c.gains().kp != GAINS.kp);
+    TEST_ASSERT_TRUE(c.gains().ki != GAINS.ki);
+    TEST_ASSERT_GREATER_THAN(1000, (int)c.gains().kd);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_filter_seeds_on_the_first_reading);
+    RUN_TEST(test_filter_drops_out_of_range_codes);
+    RUN_TEST(test_filter_holds_back_a_single_spike);
+    RUN_TEST(test_filter_follows_a_persistent_jump);
+    RUN_TEST(test_filter_median_ignores_one_odd_sample);
+    RUN_TEST(test_filter_converges_on_a_small_step);
+    RUN_TEST(test_filter_health_tracks_misses);
+    RUN_TEST(test_pid_output_saturates_both_ways);
+    RUN_TEST(test_pid_integral_does_not_wind_up);
+    RUN_TEST(test_pid_integral_holds_a_steady_duty);
+    RUN_TEST(test_pid_reset_clears_the_integral);
+    RUN_TEST(test_tiny_gains_still_load);
+    RUN_TEST(test_completed_tune_changes_the_gains);
+    return UNITY_END();
+}
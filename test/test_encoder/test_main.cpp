@@ -0,0 +1,154 @@
+// ESP32Encoder's quadrature decoder. The sim's GPIO shim reads back what
+// was last written, so each test sets the CLK/DT levels and calls tick()
+// the way the pin-change interrupt does. States are (DT << 1) | CLK and
+// both lines idle high (state 3) between detents.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "ESP32Encoder.h"
+
+namespace {
+
+const uint8_t CLK = 32;
+const uint8_t DT = 33;
+
+const uint8_t FORWARD[] = {2, 0, 1, 3};
+const uint8_t REVERSE[] = {1, 0, 2, 3};
+
+struct Turn {
+    int detents;  // sum of what tick() reported
+    int reported; // how many ticks reported anything
+};
+
+int8_t sample(ESP32Encoder &enc, uint8_t state) {
+    digitalWrite(CLK, state & 1);
+    digitalWrite(DT, (state >> 1) & 1);
+    return enc.tick();
+}
+
+Turn feed(ESP32Encoder &enc, const uint8_t *states, size_t count) {
+    Turn t = {0, 0};
+    for (size_t i = 0; i < count; i++) {
+        int8_t d = sample(enc, states[i]);
+        t.detents += d;
+        t.reported += d != 0;
+    }
+    return t;
+}
+
+// A fresh decoder starts from state 0; the first sample of the idle lines
+// is an invalid jump and only syncs it
+ESP32Encoder makeEncoder() {
+    ESP32Encoder enc(CLK, DT);
+    sample(enc, 3);
+    return enc;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_forward_detent_reports_once_on_the_last_edge() {
+    ESP32Encoder enc = makeEncoder();
+    TEST_ASSERT_EQUAL(0, enc.read());
+    TEST_ASSERT_EQUAL(0, sample(enc, FORWARD[0]));
+    TEST_ASSERT_EQUAL(0, sample(enc, FORWARD[1]));
+    TEST_ASSERT_EQUAL(0, sample(enc, FORWARD[2]));
+    TEST_ASSERT_EQUAL(+1, sample(enc, FORWARD[3]));
+    TEST_ASSERT_EQUAL(ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+void test_reverse_detent() {
+    ESP32Encoder enc = makeEncoder();
+    Turn t = feed(enc, REVERSE, sizeof(REVERSE));
+    TEST_ASSERT_EQUAL(-1, t.detents);
+    TEST_ASSERT_EQUAL(1, t.reported);
+    TEST_ASSERT_EQUAL(-ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+void test_turns_in_both_directions_add_up() {
+    ESP32Encoder enc = makeEncoder();
+    int detents = 0;
+    for (int i = 0; i < 3; i++) detents += feed(enc, FORWARD, sizeof(FORWARD)).detents;
+    for (int i = 0; i < 5; i++) detents += feed(enc, REVERSE, sizeof(REVERSE)).detents;
+    TEST_ASSERT_EQUAL(-2, detents);
+    TEST_ASSERT_EQUAL(-2 * ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+void test_contact_bounce_reports_one_detent() {
+    ESP32Encoder enc = makeEncoder();
+    // The first contact chatters before the turn completes
+    const uint8_t bouncy[] = {2, 3, 2, 3, 2, 0, 1, 3};
+    Turn t = feed(enc, bouncy, sizeof(bouncy));
+    TEST_ASSERT_EQUAL(+1, t.detents);
+    TEST_ASSERT_EQUAL(1, t.reported);
+
+    // Chatter around the detent it came to rest on reports nothing more
+    const uint8_t resting[] = {1, 3, 1, 3, 2, 3, 1, 3};
+    t = feed(enc, resting, sizeof(resting));
+    TEST_ASSERT_EQUAL(0, t.reported);
+    TEST_ASSERT_EQUAL(ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+void test_half_turn_and_back_reports_nothing() {
+    ESP32Encoder enc = makeEncoder();
+    const uint8_t rocked[] = {2, 0, 2, 3};
+    Turn t = feed(enc, rocked, sizeof(rocked));
+    TEST_ASSERT_EQUAL(0, t.reported);
+    TEST_ASSERT_EQUAL(0, enc.read());
+}
+
+void test_missed_state_never_double_counts() {
+    ESP32Encoder enc = makeEncoder();
+    // 2 -> 1 skips state 0: both lines changed between samples, which the
+    // table treats as no movement
+    const uint8_t glitch[] = {2, 1, 3};
+    Turn t = feed(enc, glitch, sizeof(glitch));
+    TEST_ASSERT_EQUAL(0, t.reported);
+    TEST_ASSERT_EQUAL(2, enc.read());
+
+    // Every later turn still reports exactly one detent
+    int reported = 0;
+    int detents = 0;
+    for (int i = 0; i < 4; i++) {
+        t = feed(enc, FORWARD, sizeof(FORWARD));
+        reported += t.reported;
+        detents += t.detents;
+    }
+    TEST_ASSERT_EQUAL(4, reported);
+    TEST_ASSERT_EQUAL(4, detents);
+}
+
+void test_write_moves_the_detent_reference() {
+    ESP32Encoder enc = makeEncoder();
+    feed(enc, FORWARD, sizeof(FORWARD));
+    enc.write(0);
+    TEST_ASSERT_EQUAL(0, enc.read());
+    Turn t = feed(enc, FORWARD, sizeof(FORWARD));
+    TEST_ASSERT_EQUAL(+1, t.detents);
+    TEST_ASSERT_EQUAL(ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+void test_read_polls_without_interrupts() {
+    ESP32Encoder enc = makeEncoder();
+    for (uint8_t state : FORWARD) {
+        digitalWrite(CLK, state & 1);
+        digitalWrite(DT, (state >> 1) & 1);
+        enc.read();
+    }
+    TEST_ASSERT_EQUAL(ESP32Encoder::COUNTS_PER_DETENT, enc.read());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_forward_detent_reports_once_on_the_last_edge);
+    RUN_TEST(test_reverse_detent);
+    RUN_TEST(test_turns_in_both_directions_add_up);
+    RUN_TEST(test_contact_bounce_reports_one_detent);
+    RUN_TEST(test_half_turn_and_back_reports_nothing);
+    RUN_TEST(test_missed_state_never_double_counts);
+    RUN_TEST(test_write_moves_the_detent_reference);
+    RUN_TEST(test_read_polls_without_interrupts);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+// Menu index math: wrapIndex() for encoder positions of either sign, the
+// editors' value mapping, and the step sizes of encoder acceleration.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <limits.h>
+#include "Menu.h"
+#include "InputEvents.h"
+
+// src/main.cpp
+int32_t editorValueAt(const ValueEditor &ed, long pos);
+
+void setUp() {}
+void tearDown() {}
+
+void test_wrap_index_in_range() {
+    TEST_ASSERT_EQUAL(0, wrapIndex(0, 7));
+    TEST_ASSERT_EQUAL(6, wrapIndex(6, 7));
+    TEST_ASSERT_EQUAL(0, wrapIndex(7, 7));
+    TEST_ASSERT_EQUAL(3, wrapIndex(703, 7));
+}
+
+void test_wrap_index_negative_positions() {
+    TEST_ASSERT_EQUAL(6, wrapIndex(-1, 7));
+    TEST_ASSERT_EQUAL(0, wrapIndex(-7, 7));
+    TEST_ASSERT_EQUAL(6, wrapIndex(-8, 7));
+    TEST_ASSERT_EQUAL(4, wrapIndex(-703, 7));
+}
+
+// abs(pos) % N mirrored the order below zero; every step must move one row
+void test_wrap_index_steps_through_zero() {
+    for (uint16_t count = 1; count <= 9; count++) {
+        for (long pos = -40; pos < 40; pos++) {
+            TEST_ASSERT_EQUAL((wrapIndex(pos, count) + 1) % count, wrapIndex(pos + 1, count));
+        }
+    }
+}
+
+void test_wrap_index_extremes() {
+    TEST_ASSERT_LESS_THAN(7, wrapIndex(LONG_MIN, 7));
+    TEST_ASSERT_LESS_THAN(7, wrapIndex(LONG_MAX, 7));
+    TEST_ASSERT_EQUAL(0, wrapIndex(LONG_MIN, 1));
+}
+
+void test_editor_maps_rows_to_values() {
+    const ValueEditor timer = {EDIT_TIMER, SLOT_ACTIVE, 1200, 289, 600, nullptr, 0};
+    TEST_ASSERT_EQUAL(1200, editorValueAt(timer, 0));
+    TEST_ASSERT_EQUAL(1800, editorValueAt(timer, 1));
+    TEST_ASSERT_EQUAL(1200 + 288 * 600, editorValueAt(timer, 288));
+    TEST_ASSERT_EQUAL(1200 + 288 * 600, editorValueAt(timer, -1));
+}
+
+void test_slow_detents_step_by_one() {
+    EncoderAcceleration accel;
+    TEST_ASSERT_EQUAL(+1, accel.step(+1, 1000)); // first detent
+    TEST_ASSERT_EQUAL(+1, accel.step(+1, 1000 + EncoderAcceleration::SLOW_MS));
+    TEST_ASSERT_EQUAL(-1, accel.step(-1, 2000));
+}
+
+void test_fast_spin_scales_the_step() {
+    EncoderAcceleration accel;
+    accel.step(+1, 1000);
+    TEST_ASSERT_EQUAL(EncoderAcceleration::MAX_STEP, accel.step(+1, 1000 + EncoderAcceleration::FAST_MS));
+    TEST_ASSERT_EQUAL(-1, accel.step(-1, 1030));
+    TEST_ASSERT_EQUAL(-(int)EncoderAcceleration::MAX_STEP, accel.step(-1, 1040));
+
+    // In between, the step grows as the gap shrinks
+    int8_t last = 0;
+    unsigned long now = 5000;
+    accel.step(+1, now);
+    for (unsigned long gap = EncoderAcceleration::SLOW_MS; gap >= EncoderAcceleration::FAST_MS; gap -= 5) {
+        now += gap;
+        int8_t step = accel.step(+1, now);
+        TEST_ASSERT_GREATER_OR_EQUAL(last, step);
+        TEST_ASSERT_LESS_OR_EQUAL(EncoderAcceleration::MAX_STEP, step);
+        last = step;
+    }
+}
+
+void test_direction_change_restarts_at_one() {
+    EncoderAcceleration accel;
+    accel.step(+1, 1000);
+    accel.step(+1, 1005);
+    TEST_ASSERT_EQUAL(-1, accel.step(-1, 1010));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_wrap_index_in_range);
+    RUN_TEST(test_wrap_index_negative_positions);
+    RUN_TEST(test_wrap_index_steps_through_zero);
+    RUN_TEST(test_wrap_index_extremes);
+    RUN_TEST(test_editor_maps_rows_to_values);
+    RUN_TEST(test_slow_detents_step_by_one);
+    RUN_TEST(test_fast_spin_scales_the_step);
+    RUN_TEST(test_direction_change_restarts_at_one);
+    return UNITY_END();
+}
@@ -0,0 +1,100 @@
+// SensorManager against the sim's Si7021s: pipelined sampling, and the
+// two-step re-probe that keeps a lost or returning sensor from blocking
+// the control task.
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <unity.h>
+#include "Sim.h"
+#include "SensorManager.h"
+
+namespace {
+
+const uint8_t CH = 2;
+bool fitted = true;
+
+bool fakeSensor(uint8_t channel, float &tempC, float &humidity) {
+    if (channel != CH || !fitted) return false;
+    tempC = 25.0f;
+    humidity = 40.0f;
+    return true;
+}
+
+I2cBus bus(Wire, 21, 22);
+Adafruit_Si7021 driver(&Wire);
+SensorManager sensors(bus, driver);
+
+// One SAMPLE_INTERVAL_MS worth of control periods: start, collect, wait.
+// Returns how far those two calls moved the clock themselves.
+unsigned long cycle() {
+    unsigned long before = millis();
+    sensors.startCycle();
+    unsigned long spent = millis() - before;
+    sim::advance(SensorManager::CONVERSION_MS + 5);
+    before = millis();
+    sensors.collectCycle();
+    spent += millis() - before;
+    sim::advance(500);
+    return spent;
+}
+
+} // namespace
+
+void setUp() {
+    fitted = true;
+    sim::setSensors(fakeSensor);
+    bus.begin();
+    sensors.begin(1 << CH);
+}
+
+void tearDown() {}
+
+void test_present_sensor_is_sampled() {
+    TEST_ASSERT_TRUE(sensors.present(CH));
+    cycle();
+    const SensorManager::Sample &s = sensors.sample(CH);
+    TEST_ASSERT_INT_WITHIN(1, 770, s.temperature); // 25 C
+    TEST_ASSERT_INT_WITHIN(2, 400, s.humidity);
+    TEST_ASSERT_TRUE(s.timestamp != 0);
+}
+
+void test_lost_sensor_is_dropped_after_max_failures() {
+    fitted = false;
+    for (uint8_t i = 0; i < SensorManager::MAX_FAILURES; i++) cycle();
+    TEST_ASSERT_FALSE(sensors.present(CH));
+}
+
+void test_returning_sensor_is_found_again() {
+    fitted = false;
+    for (uint8_t i = 0; i < SensorManager::MAX_FAILURES; i++) cycle();
+    fitted = true;
+    uint16_t cycles = 0;
+    while (!sensors.present(CH) && cycles < 2 * SensorManager::REPROBE_POLLS + 4) {
+        cycle();
+        cycles++;
+    }
+    TEST_ASSERT_TRUE(sensors.present(CH));
+    unsigned long before = sensors.sample(CH).timestamp;
+    cycle();
+    TEST_ASSERT_TRUE(sensors.sample(CH).timestamp != before);
+}
+
+// The driver's probe waits 50 ms; none of that may happen inside a cycle
+void test_reprobes_never_block_a_cycle() {
+    fitted = false;
+    unsigned long spent = 0;
+    for (uint16_t i = 0; i < 3 * SensorManager::REPROBE_POLLS; i++) spent += cycle();
+    fitted = true;
+    for (uint16_t i = 0; i < 3 * SensorManager::REPROBE_POLLS; i++) spent += cycle();
+    TEST_ASSERT_EQUAL(0, spent);
+    TEST_ASSERT_TRUE(sensors.present(CH));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_present_sensor_is_sampled);
+    RUN_TEST(test_lost_sensor_is_dropped_after_max_failures);
+    RUN_TEST(test_returning_sensor_is_found_again);
+    RUN_TEST(test_reprobes_never_block_a_cycle);
+    return UNITY_END();
+}
@@ -0,0 +1,158 @@
+// EEPROM persistence: RecordRing's newest-valid-record recovery, and the
+// write coalescing SettingsStore and RunJournal build on it. Each test
+// uses its own address range of the emulated EEPROM, clear of main.cpp's.
+
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <unity.h>
+#include "Sim.h"
+#include "RecordRing.h"
+#include "SettingsStore.h"
+#include "RunJournal.h"
+
+namespace {
+
+struct Sample {
+    int16_t setpoint;
+    uint8_t flags; // followed by a padding byte
+
+    bool operator==(const Sample &o) const {
+        return setpoint == o.setpoint && flags == o.flags;
+    }
+};
+
+typedef RecordRing<Sample, 2, 0x5445> Ring;
+
+const uint8_t VERSION = 1;
+int nextBase = 1024;
+
+// A fresh, erased address range for one test
+int freshBase() {
+    int base = nextBase;
+    nextBase += 256;
+    for (int i = 0; i < 256; i++) EEPROM.write(base + i, 0xFF);
+    return base;
+}
+
+Sample sample(int16_t setpoint) {
+    Sample s = {setpoint, 0};
+    return s;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_empty_ring_leaves_the_defaults() {
+    Ring ring(freshBase(), VERSION);
+    Sample out = sample(-1);
+    TEST_ASSERT_FALSE(ring.load(out));
+    TEST_ASSERT_EQUAL(-1, out.setpoint);
+}
+
+void test_ring_loads_the_newest_record_after_a_reset() {
+    int base = freshBase();
+    Ring before(base, VERSION);
+    for (int16_t sp = 800; sp <= 1000; sp += 100) before.write(sample(sp));
+
+    Ring after(base, VERSION);
+    Sample out = sample(-1);
+    TEST_ASSERT_TRUE(after.load(out));
+    TEST_ASSERT_EQUAL(1000, out.setpoint);
+    TEST_ASSERT_EQUAL(before.sequence(), after.sequence());
+
+    after.write(sample(1100)); // continues the sequence, not slot 0
+    Ring again(base, VERSION);
+    TEST_ASSERT_TRUE(again.load(out));
+    TEST_ASSERT_EQUAL(1100, out.setpoint);
+}
+
+void test_corrupt_record_falls_back_to_the_previous() {
+    int base = freshBase();
+    Ring ring(base, VERSION);
+    ring.write(sample(800)); // slot 0
+    ring.write(sample(900)); // slot 1
+    int recordBytes = Ring::STORAGE_BYTES / 2;
+    EEPROM.write(base + recordBytes + 8, 0x5A); // a byte of slot 1's data
+
+    Ring after(base, VERSION);
+    Sample out = sample(-1);
+    TEST_ASSERT_TRUE(after.load(out));
+    TEST_ASSERT_EQUAL(800, out.setpoint);
+}
+
+void test_other_version_is_ignored() {
+    int base = freshBase();
+    Ring(base, VERSION).write(sample(800));
+    Ring newer(base, VERSION + 1);
+    Sample out = sample(-1);
+    TEST_ASSERT_FALSE(newer.load(out));
+    TEST_ASSERT_EQUAL(-1, out.setpoint);
+}
+
+void test_settings_coalesce_and_skip_unchanged_commits() {
+    Sample live = sample(700);
+    SettingsStore<Sample> store(live, freshBase(), VERSION);
+    TEST_ASSERT_FALSE(store.begin());
+
+    live.setpoint = 750;
+    store.markDirty();
+    sim::advance(1000);
+    live.setpoint = 800;
+    store.markDirty();
+    store.service(5000);
+    TEST_ASSERT_EQUAL(0, store.commits()); // still inside the quiet window
+    sim::advance(5000);
+    store.service(5000);
+    TEST_ASSERT_EQUAL(1, store.commits());
+
+    store.markDirty(); // nothing actually changed
+    store.flush();
+    TEST_ASSERT_EQUAL(1, store.commits());
+    TEST_ASSERT_FALSE(store.dirty());
+}
+
+// Padding is not part of the settings: a stray byte there is no change
+void test_settings_padding_is_not_a_change() {
+    Sample live = sample(700);
+    SettingsStore<Sample> store(live, freshBase(), VERSION);
+    store.begin();
+    reinterpret_cast<uint8_t *>(&live)[sizeof(Sample) - 1] ^= 0x55;
+    store.markDirty();
+    store.flush();
+    TEST_ASSERT_EQUAL(0, store.commits());
+}
+
+void test_journal_batches_appends() {
+    int base = freshBase();
+    RunJournal<Sample, 2> journal(base, VERSION);
+    Sample out = sample(-1);
+    TEST_ASSERT_FALSE(journal.begin(out));
+
+    journal.append(sample(800));
+    sim::advance(500);
+    journal.append(sample(900)); // same window: replaces the staged record
+    journal.service(2000);
+    TEST_ASSERT_TRUE(journal.pending());
+    sim::advance(1500);
+    journal.service(2000);
+    TEST_ASSERT_FALSE(journal.pending());
+    TEST_ASSERT_EQUAL(1, journal.commits());
+
+    RunJournal<Sample, 2> replay(base, VERSION);
+    TEST_ASSERT_TRUE(replay.begin(out));
+    TEST_ASSERT_EQUAL(900, out.setpoint);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_ring_leaves_the_defaults);
+    RUN_TEST(test_ring_loads_the_newest_record_after_a_reset);
+    RUN_TEST(test_corrupt_record_falls_back_to_the_previous);
+    RUN_TEST(test_other_version_is_ignored);
+    RUN_TEST(test_settings_coalesce_and_skip_unchanged_commits);
+    RUN_TEST(test_settings_padding_is_not_a_change);
+    RUN_TEST(test_journal_batches_appends);
+    return UNITY_END();
+}
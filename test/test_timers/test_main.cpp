@@ -0,0 +1,121 @@
+// Timer arithmetic: EventQueue ordering, cancellation and millis() wrap,
+// and the rounding of secondsUntil() behind the zone countdowns.
+
+#include <Arduino.h>
+#include <unity.h>
+#include "EventQueue.h"
+
+namespace {
+
+typedef EventQueue<8> Queue;
+
+// Pop everything due at nowMs into `types`; returns how many fired
+uint8_t drain(Queue &q, unsigned long nowMs, uint8_t *types, uint8_t max) {
+    Queue::Event e;
+    uint8_t n = 0;
+    while (n < max && q.pop(nowMs, e)) types[n++] = e.type;
+    return n;
+}
+
+} // namespace
+
+void setUp() {}
+void tearDown() {}
+
+void test_events_fire_in_deadline_order() {
+    Queue q;
+    q.schedule(3000, 0, 3);
+    q.schedule(1000, 0, 1);
+    q.schedule(4000, 1, 4);
+    q.schedule(2000, 1, 2);
+    uint8_t types[8];
+    TEST_ASSERT_EQUAL(4, drain(q, 10000, types, 8));
+    for (uint8_t i = 0; i < 4; i++) TEST_ASSERT_EQUAL(i + 1, types[i]);
+    TEST_ASSERT_EQUAL(0, q.size());
+}
+
+void test_nothing_fires_before_its_deadline() {
+    Queue q;
+    q.schedule(1000, 0, 7);
+    Queue::Event e;
+    TEST_ASSERT_FALSE(q.pop(999, e));
+    TEST_ASSERT_TRUE(q.pop(1000, e));
+    TEST_ASSERT_EQUAL(7, e.type);
+    TEST_ASSERT_FALSE(q.pop(5000, e)); // exactly once
+}
+
+void test_late_poll_fires_only_what_is_due() {
+    Queue q;
+    q.schedule(100, 0, 1);
+    q.schedule(200, 0, 2);
+    q.schedule(900, 0, 3);
+    uint8_t types[8];
+    TEST_ASSERT_EQUAL(2, drain(q, 500, types, 8));
+    TEST_ASSERT_EQUAL(1, q.size());
+}
+
+void test_cancel_by_owner_and_type() {
+    Queue q;
+    q.schedule(100, 0, 1);
+    q.schedule(200, 1, 1);
+    q.schedule(300, 0, 2);
+    q.schedule(400, 1, 2);
+    q.cancel(1, 2);
+    TEST_ASSERT_EQUAL(3, q.size());
+    q.cancel(0);
+    TEST_ASSERT_EQUAL(1, q.size());
+    Queue::Event e;
+    TEST_ASSERT_TRUE(q.pop(1000, e));
+    TEST_ASSERT_EQUAL(1, e.owner);
+    TEST_ASSERT_EQUAL(1, e.type);
+}
+
+void test_schedule_refuses_when_full() {
+    Queue q;
+    for (uint8_t i = 0; i < Queue::capacity(); i++) TEST_ASSERT_TRUE(q.schedule(i, 0, 0));
+    TEST_ASSERT_FALSE(q.schedule(99, 0, 0));
+}
+
+void test_order_holds_across_millis_wrap() {
+    Queue q;
+    const unsigned long nearWrap = 0xFFFFFF00UL;
+    q.schedule(nearWrap + 0x200, 0, 2); // past the wrap: a small number
+    q.schedule(nearWrap + 0x80, 0, 1);
+    Queue::Event e;
+    TEST_ASSERT_FALSE(q.pop(nearWrap, e));
+    TEST_ASSERT_TRUE(q.pop(nearWrap + 0x80, e));
+    TEST_ASSERT_EQUAL(1, e.type);
+    TEST_ASSERT_FALSE(q.pop(nearWrap + 0x100, e));
+    TEST_ASSERT_TRUE(q.pop(nearWrap + 0x200, e));
+    TEST_ASSERT_EQUAL(2, e.type);
+}
+
+void test_seconds_until_rounds_up() {
+    TEST_ASSERT_EQUAL(10, secondsUntil(10000, 0));
+    TEST_ASSERT_EQUAL(10, secondsUntil(10000, 1));
+    TEST_ASSERT_EQUAL(1, secondsUntil(10000, 9999));
+    TEST_ASSERT_EQUAL(0, secondsUntil(10000, 10000));
+    TEST_ASSERT_EQUAL(0, secondsUntil(10000, 20000));
+}
+
+void test_seconds_until_a_48_hour_timer_across_the_wrap() {
+    const unsigned long start = 0xFFFFFFFFUL - 3600000UL; // an hour before millis() wraps
+    const unsigned long duration = 48UL * 3600UL;
+    unsigned long due = start + duration * 1000UL;
+    TEST_ASSERT_EQUAL(duration, secondsUntil(due, start));
+    TEST_ASSERT_EQUAL(duration - 7200, secondsUntil(due, start + 7200000UL));
+    TEST_ASSERT_EQUAL(0, secondsUntil(due, due + 1));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_events_fire_in_deadline_order);
+    RUN_TEST(test_nothing_fires_before_its_deadline);
+    RUN_TEST(test_late_poll_fires_only_what_is_due);
+    RUN_TEST(test_cancel_by_owner_and_type);
+    RUN_TEST(test_schedule_refuses_when_full);
+    RUN_TEST(test_order_holds_across_millis_wrap);
+    RUN_TEST(test_seconds_until_rounds_up);
+    RUN_TEST(test_seconds_until_a_48_hour_timer_across_the_wrap);
+    return UNITY_END();
+}